@@ -21,8 +21,8 @@
 ALWAYS_INLINE u64 time_ns() {
 /* #ifdef CJAM_HAS_CLOCK_GETTIME */
     struct timespec ts;
-    // TODO: is CLOCK_REALTIME cross platform enough?
-    clock_gettime(CLOCK_REALTIME, &ts);
+    // monotonic so deltas can't jump/go negative on wall clock adjustments
+    clock_gettime(CLOCK_MONOTONIC, &ts);
     return (ts.tv_sec * ((u64) 1000000000UL)) + (u64) (ts.tv_nsec);
 /* #elifdef CJAM_SDL */
 /*     return SDL_GetTicks64() * 1000; */
@@ -3,6 +3,7 @@
 // PRECIOUS CARGO (AND SCARY ALIENS WHO WANT TO TAKE IT!)
 
 #include <cjam/types.h>
+#include <cjam/macros.h>
 
 #define WINDOW_SIZE ((ivec2s) {{ 948, 533 }})
 #define TARGET_SIZE ((ivec2s) {{ 192, 108 }})
@@ -24,7 +25,13 @@
 #define LEVEL_HEIGHT (108 / 8)
 #define LEVEL_SIZE ((ivec2s) {{ LEVEL_WIDTH, LEVEL_HEIGHT }})
 
-#define MAX_ENTITIES 16384
+// entity_id.index is a u16
+#define MAX_ENTITIES 65536
+
+// entities are allocated this many at a time, see level_new_entity
+#define ENTITY_CHUNK_SIZE 256
+#define ENTITY_CHUNK_SHIFT 8
+#define MAX_ENTITY_CHUNKS (MAX_ENTITIES / ENTITY_CHUNK_SIZE)
 
 #define MAX_TRUCK_HEALTH 100
 #define MAX_TRUCK_ARMOR 3
@@ -76,44 +83,52 @@ typedef struct {
 
 #define ENTITY_NONE ((entity_id) { 0 })
 
+// entity type registry, _m(NAME, name, tick, draw, flags) for each type.
+// generates the entity_type enum, entity_type_flags, the switch dispatch in
+// entity.c (tick_<tick>/draw_<draw>, "none" for nothing) and trace names.
+#define ENTITY_TYPES(_m)                                                       \
+    _m(TURRET_L0, turret_l0, turret, turret, EIF_PLACEABLE)                    \
+    _m(TURRET_L1, turret_l1, turret, turret, EIF_PLACEABLE)                    \
+    _m(TURRET_L2, turret_l2, turret, turret, EIF_PLACEABLE)                    \
+    _m(CANNON_L0, cannon_l0, turret, turret, EIF_PLACEABLE)                    \
+    _m(CANNON_L1, cannon_l1, turret, turret, EIF_PLACEABLE)                    \
+    _m(MINE_L0, mine_l0, mine, basic, EIF_PLACEABLE | EIF_CAN_SPAWN)           \
+    _m(MINE_L1, mine_l1, mine, basic, EIF_PLACEABLE | EIF_CAN_SPAWN)           \
+    _m(MINE_L2, mine_l2, mine, basic, EIF_PLACEABLE | EIF_CAN_SPAWN)           \
+    _m(RADAR_L0, radar_l0, basic_building, radar, EIF_PLACEABLE)               \
+    _m(RADAR_L1, radar_l1, basic_building, radar, EIF_PLACEABLE)               \
+    _m(BULLET_L0, bullet_l0, bullet, basic, EIF_DOES_NOT_BLOCK)                \
+    _m(BULLET_L1, bullet_l1, bullet, basic, EIF_DOES_NOT_BLOCK)                \
+    _m(BULLET_L2, bullet_l2, bullet, basic, EIF_DOES_NOT_BLOCK)                \
+    _m(SHELL_L0, shell_l0, bullet, basic, EIF_DOES_NOT_BLOCK)                  \
+    _m(SHELL_L1, shell_l1, bullet, basic, EIF_DOES_NOT_BLOCK)                  \
+    _m(BOOMBOX, boombox, boombox, basic, EIF_PLACEABLE)                        \
+    _m(START_POINT, start_point, none, none, EIF_NONE)                         \
+    _m(FLAG, flag, none, basic, EIF_NONE)                                      \
+    _m(DECOY_TRUCK, decoy_truck, basic_building, basic, EIF_PLACEABLE)         \
+    _m(TRUCK, truck, truck, truck, EIF_NONE)                                   \
+    _m(ALIEN_L0, alien_l0, alien, alien, EIF_ENEMY | EIF_ALIEN)                \
+    _m(ALIEN_L1, alien_l1, alien, alien, EIF_ENEMY | EIF_ALIEN)                \
+    _m(ALIEN_L2, alien_l2, alien, alien, EIF_ENEMY | EIF_ALIEN)                \
+    _m(ALIEN_FAST, alien_fast, alien, alien, EIF_ENEMY | EIF_ALIEN)            \
+    _m(ALIEN_TANK, alien_tank, alien, alien, EIF_ENEMY | EIF_ALIEN)            \
+    _m(ALIEN_GHOST, alien_ghost, alien, alien, EIF_ENEMY | EIF_ALIEN)          \
+    _m(SHIP_L0, ship_l0, ship, ship, EIF_ENEMY | EIF_SHIP)                     \
+    _m(SHIP_L1, ship_l1, ship, ship, EIF_ENEMY | EIF_SHIP)                     \
+    _m(SHIP_L2, ship_l2, ship, ship, EIF_ENEMY | EIF_SHIP)                     \
+    _m(TRANSPORT_L0, transport_l0, ship, ship, EIF_ENEMY | EIF_SHIP)           \
+    _m(TRANSPORT_L1, transport_l1, ship, ship, EIF_ENEMY | EIF_SHIP)           \
+    _m(TRANSPORT_L2, transport_l2, ship, ship, EIF_ENEMY | EIF_SHIP)           \
+    _m(FLAGSHIP, flagship, ship, ship, EIF_ENEMY | EIF_SHIP)                   \
+    _m(REPAIR, repair, none, none, EIF_NOT_AN_ENTITY)                          \
+    _m(ARMOR_UPGRADE, armor_upgrade, none, none, EIF_NOT_AN_ENTITY)            \
+    _m(SPEED_UPGRADE, speed_upgrade, none, none, EIF_NOT_AN_ENTITY)
+
 typedef enum {
     ENTITY_TYPE_NONE = 0,
-    ENTITY_TURRET_L0,
-    ENTITY_TURRET_L1,
-    ENTITY_TURRET_L2,
-    ENTITY_CANNON_L0,
-    ENTITY_CANNON_L1,
-    ENTITY_MINE_L0,
-    ENTITY_MINE_L1,
-    ENTITY_MINE_L2,
-    ENTITY_RADAR_L0,
-    ENTITY_RADAR_L1,
-    ENTITY_BULLET_L0,
-    ENTITY_BULLET_L1,
-    ENTITY_BULLET_L2,
-    ENTITY_SHELL_L0,
-    ENTITY_SHELL_L1,
-    ENTITY_BOOMBOX,
-    ENTITY_START_POINT,
-    ENTITY_FLAG,
-    ENTITY_DECOY_TRUCK,
-    ENTITY_TRUCK,
-    ENTITY_ALIEN_L0,
-    ENTITY_ALIEN_L1,
-    ENTITY_ALIEN_L2,
-    ENTITY_ALIEN_FAST,
-    ENTITY_ALIEN_TANK,
-    ENTITY_ALIEN_GHOST,
-    ENTITY_SHIP_L0,
-    ENTITY_SHIP_L1,
-    ENTITY_SHIP_L2,
-    ENTITY_TRANSPORT_L0,
-    ENTITY_TRANSPORT_L1,
-    ENTITY_TRANSPORT_L2,
-    ENTITY_FLAGSHIP,
-    ENTITY_REPAIR,
-    ENTITY_ARMOR_UPGRADE,
-    ENTITY_SPEED_UPGRADE,
+#define ENTITY_TYPE_ENUM(_n, ...) ENTITY_##_n,
+    ENTITY_TYPES(ENTITY_TYPE_ENUM)
+#undef ENTITY_TYPE_ENUM
     ENTITY_TYPE_COUNT
 } entity_type;
 
@@ -129,6 +144,18 @@ enum {
     EIF_CAN_SPAWN = 1 << 6,
 };
 
+#define EIF_NUM_FLAGS 7
+
+// EIF_* flags of a type, folds to a constant when type is one
+ALWAYS_INLINE int entity_type_flags(entity_type type) {
+    switch (type) {
+#define ENTITY_TYPE_FLAGS(_n, _name, _t, _d, _f) case ENTITY_##_n: return (_f);
+    ENTITY_TYPES(ENTITY_TYPE_FLAGS)
+#undef ENTITY_TYPE_FLAGS
+    default: return EIF_NONE;
+    }
+}
+
 // level tile flags
 enum {
     LTF_NONE = 0,
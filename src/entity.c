@@ -34,78 +34,85 @@ void entity_set_pos(entity *e, vec2s pos) {
         || e->tile.x != new_tile.x
         || e->tile.y != new_tile.y;
 
-    if (e->on_tile && is_new_tile) {
-        dlist_remove(
-            tile_node,
-            &state->level->tile_entities[e->tile.x][e->tile.y],
-            e);
-    }
+    const bool was_on_tile = e->on_tile;
+    const ivec2s old_tile = e->tile;
 
     e->pos = pos;
     e->px = (ivec2s) {{ roundf(pos.x), roundf(pos.y) }};
     e->tile = new_tile;
     e->on_tile = level_tile_in_bounds(e->tile);
 
-    if (is_new_tile && e->on_tile) {
-        ASSERT(e->tile_node.next == NULL && e->tile_node.prev == NULL);
-        ASSERT(e->on_tile);
-        dlist_append(
-            tile_node,
-            &state->level->tile_entities[e->tile.x][e->tile.y],
-            e);
+    entity_store *hot = &state->level->hot;
+    hot->pos[e->slot] = e->pos;
+    hot->px[e->slot] = e->px;
+    hot->tile[e->slot] = e->tile;
+
+    if (is_new_tile) { state->level->grid_dirty = true; }
+
+    // bullets test enemy_boxes, which has to follow moves within a tile too
+    if (e->enemy_box >= 0) {
+        state->level->enemy_boxes[e->enemy_box] = entity_aabb(e);
+    }
+
+    if (is_new_tile && (E_FLAGS(e) & EIF_ENEMY)) {
+        level_move_enemy(state->level, e, was_on_tile, old_tile);
     }
 }
 
+void entity_set_health(entity *e, f32 health) {
+    e->health = health;
+    state->level->hot.health[e->slot] = health;
+}
+
 aabb entity_aabb(const entity *e) {
-    const entity_info *info = &ENTITY_INFO[e->type];
-    return aabb_translate(info->aabb, VEC2S2I(e->pos));
+    return aabb_translate(E_HOT(e)->aabb, VEC2S2I(e->pos));
 }
 
 ivec2s entity_center(const entity *e) {
     return aabb_center(entity_aabb(e));
 }
 
-static int find_collisions(const aabb *aabb, entity **entities, int n) {
-    const ivec2s
-        tmin = level_clamp_tile(glms_ivec2_add(level_px_to_tile(aabb->min), IVEC2S(-1))),
-        tmax = level_clamp_tile(glms_ivec2_add(level_px_to_tile(aabb->max), IVEC2S(+1)));
-
-    int i = 0;
-    for (int x = tmin.x; x <= tmax.x; x++) {
-        for (int y = tmin.y; y <= tmax.y; y++) {
-            dlist_each(tile_node, &state->level->tile_entities[x][y], it) {
-                const struct aabb_s b = entity_aabb(it.el);
-                if (aabb_collides(*aabb, b)) {
-                    entities[i++] = it.el;
-                    if (i == n) {
-                        WARN("ran out of space for collisions");
-                        return n;
-                    }
-                }
-            }
-        }
-    }
+// position to draw at, between last and current tick by the snapshot's alpha
+vec2s entity_draw_pos(const entity *e) {
+    // not ticked yet, nothing to interpolate from
+    if (e->ticks_alive == 0) { return e->pos; }
+    return glms_vec2_lerp(e->prev_pos, e->pos, state->render->alpha);
+}
 
-    return i;
+ivec2s entity_draw_px(const entity *e) {
+    const vec2s pos = entity_draw_pos(e);
+    return (ivec2s) {{ roundf(pos.x), roundf(pos.y) }};
 }
 
-static entity *shoot_bullet(entity_type type, vec2s origin, vec2s dir, ivec2s target) {
-    entity_info *info = &ENTITY_INFO[type];
-    entity *e = level_new_entity(state->level, type);
-    e->bullet.velocity = glms_vec2_scale(dir, info->bullet.speed);
-    entity_set_pos(e, origin);
+static void shoot_bullet(entity_type type, vec2s origin, vec2s dir, ivec2s target) {
+    const entity_info *info = &ENTITY_INFO[type];
+    level_push_command(
+        state->level,
+        (level_command) {
+            .type = LEVEL_COMMAND_SPAWN,
+            .spawn = {
+                .type = type,
+                .pos = origin,
+                .velocity = glms_vec2_scale(dir, info->bullet.speed),
+                .target = target,
+                .has_target = info->bullet.is_shell,
+            }
+        });
 
     if (state->tick_bullet_sounds < 2) {
         state->tick_bullet_sounds++;
         sound_play("shoot.wav", 0.25f);
     }
+}
 
-    if (info->bullet.is_shell) {
-        e->bullet.has_target = true;
-        e->bullet.target = target;
-    }
-
-    return e;
+// queue damage to e for the end of the tick
+static void damage_entity(entity *e, f32 amount) {
+    level_push_command(
+        state->level,
+        (level_command) {
+            .type = LEVEL_COMMAND_DAMAGE,
+            .damage = { .target = e->id, .amount = amount }
+        });
 }
 
 // move e to point
@@ -156,6 +163,44 @@ static bool entity_move_on_path(
     return false;
 }
 
+// first tick after "after" on which (tick + offset) % period == 0
+static u64 next_period(u64 after, int offset, int period) {
+    const u64 t = after + 1;
+    return t + ((period - ((t + offset) % period)) % period);
+}
+
+// how many times something happening per_tick times a tick (offset by offset
+// ticks) happens on tick
+static int cadence(u64 tick, int offset, f32 per_tick) {
+    const int t = tick + offset;
+    return ((int) (floorf(t * per_tick))) - ((int) (floorf((t - 1) * per_tick)));
+}
+
+// first tick after "after" on which cadence is not 0, per_tick must be > 0
+static u64 next_cadence(u64 after, int offset, f32 per_tick) {
+    const int t = after + offset;
+    i64 next =
+        ((i64) ceilf((floorf(t * per_tick) + 1.0f) / per_tick)) - offset;
+    next = max(next, (i64) after + 1);
+
+    // float rounding can put the estimate a tick or so out
+    while (next > (i64) after + 1 && cadence(next - 1, offset, per_tick) > 0) {
+        next--;
+    }
+
+    while (cadence(next, offset, per_tick) == 0) {
+        next++;
+    }
+
+    return next;
+}
+
+// schedule action on tick unless it already is
+static void arm(entity *e, entity_timer action, int arg, u64 tick) {
+    if (e->timers & (1 << action)) { return; }
+    level_schedule(state->level, e, action, arg, tick);
+}
+
 static bool check_building_death(entity *e) {
     if (e->health < e->last_health && (state->time.tick % 5 == 0)) {
         play_hit_sound();
@@ -180,31 +225,21 @@ static bool check_building_death(entity *e) {
 
 static void explosion(vec2s pos, f32 radius, f32 damage) {
     const aabb area = AABB_CH(VEC2S2I(pos), IVEC2S(radius));
-    entity *around[64];
-    const int m =
-        level_get_box_entities(
-            state->level,
-            &area,
-            around,
-            64);
-
-    for (int i = 0; i < m; i++) {
-        entity *f = around[i];
-        if (E_INFO(f)->flags & EIF_ENEMY) {
-            const f32 invdist =
-                clamp(
-                    1.0f - (glms_vec2_norm(glms_vec2_sub(f->pos, pos)) / radius),
-                    0.0f, 1.0f);
-
-            const f32 d = damage * (0.6f + invdist);
-            f->health -= d;
-            particle_new_multi_splat(
-                IVEC2S2V(entity_center(f)),
-                palette_get(E_INFO(f)->palette),
-                10,
-                2, 4,
-                false);
-        }
+    level_enemy_box_each(state->level, &area, it) {
+        entity *f = it.el;
+        const f32 invdist =
+            clamp(
+                1.0f - (glms_vec2_norm(glms_vec2_sub(f->pos, pos)) / radius),
+                0.0f, 1.0f);
+
+        const f32 d = damage * (0.6f + invdist);
+        damage_entity(f, d);
+        particle_new_multi_splat(
+            IVEC2S2V(entity_center(f)),
+            palette_get(E_HOT(f)->palette),
+            10,
+            2, 4,
+            false);
     }
 
     particle_new_multi_smoke(
@@ -223,15 +258,15 @@ static void explosion(vec2s pos, f32 radius, f32 damage) {
 }
 
 static void tick_mine(entity *e) {
-    if (state->stage != STAGE_PLAY) { return; }
-
-    entity *entities[64];
-    const int n = level_get_tile_entities(state->level, e->tile, entities, 64);
+    if (state->stage != STAGE_PLAY) {
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+        return;
+    }
 
     bool explode = false;
 
-    for (int i = 0; i < n; i++) {
-        if (E_INFO(entities[i])->flags & EIF_ENEMY) {
+    level_tile_each(state->level, e->tile, it) {
+        if (E_FLAGS(it.el) & EIF_ENEMY) {
             explode = true;
             break;
         }
@@ -247,6 +282,9 @@ static void tick_mine(entity *e) {
             IVEC2S2V(entity_center(e)),
             5 + (mod * 3),
             5.0f + (mod * 12.0f));
+    } else if (!level_region_enemies(state->level, e->tile)) {
+        // nothing can step on it before an enemy gets to its region
+        level_sleep_entity(state->level, e, LEVEL_WAKE_REGION);
     }
 }
 
@@ -263,78 +301,138 @@ static int truck_path_weight(const level *l, ivec2s p, void*) {
     return 1;
 }
 
-int priority_turret_target(entity *e, entity *turret) {
-    if (!(E_INFO(e)->flags & EIF_ENEMY)) { return -1; }
+// idle spinning per tick
+#define TURRET_IDLE_SPIN 0.1f
 
-    if (E_INFO(e)->flags & EIF_SHIP) {
-        return 1;
-    }
+// ticks between looking for a target when there is none
+#define TURRET_RETARGET_TICKS 5
 
-    return 2;
+static f32 turret_bullets_per_tick(const entity *e) {
+    return E_INFO(e)->turret.bps / TICKS_PER_SECOND;
 }
 
-static void tick_turret(entity *e) {
-    if (state->stage != STAGE_PLAY) {
-        e->turret.angle += 0.1f;
-        return;
-    }
+// finds and keeps the best target, the turret is kept awake to aim at it
+static entity *retarget_turret(entity *e) {
+    entity *target =
+        level_get_entity(
+            state->level, level_turret_target(state->level, e->tile));
+    e->turret.target = target ? target->id : ENTITY_NONE;
 
-    if (check_building_death(e)) { return; }
+    if (target) { level_wake_entity(state->level, e); }
+    return target;
+}
 
-    const entity_info *info = &ENTITY_INFO[e->type];
-    const f32 bpt = info->turret.bps / TICKS_PER_SECOND;
-    const int t = state->time.tick + e->id.index;
-    const int n_shoot = ((int) (floorf(t * bpt))) - ((int) (floorf((t - 1) * bpt)));
+// point at target, returns the direction to shoot in from *origin
+static vec2s aim_turret(entity *e, const entity *target, vec2s *origin) {
+    *origin = (vec2s) {{ e->pos.x + 4, e->pos.y + 5 }};
+    const vec2s dir =
+        glms_vec2_normalize(
+            glms_vec2_sub(IVEC2S2V(entity_center(target)), *origin));
+    e->turret.angle = -atan2f(dir.y, dir.x);
+    return dir;
+}
 
-    entity *target = level_get_entity(state->level, e->turret.target);
+static void arm_turret(entity *e) {
+    const u64 now = state->time.tick;
+    arm(e, ENTITY_TIMER_RETARGET, 0,
+        next_period(now, e->id.index, TURRET_RETARGET_TICKS));
+    arm(e, ENTITY_TIMER_FIRE, 0,
+        next_cadence(now, e->id.index, turret_bullets_per_tick(e)));
+}
 
-    if (n_shoot > 0 && info->turret.is_cannon) {
-        goto new_target;
-    }
+// turret timers lapse outside STAGE_PLAY, tick_turret re-arms them
+static void timer_turret_retarget(entity *e) {
+    if (state->stage != STAGE_PLAY || e->health <= 0) { return; }
+
+    level_schedule(
+        state->level, e, ENTITY_TIMER_RETARGET, 0,
+        next_period(state->time.tick, e->id.index, TURRET_RETARGET_TICKS));
 
-    if (target) {
-        goto shoot;
+    if (!level_get_entity(state->level, e->turret.target)
+        && level_has_enemies(state->level)) {
+        retarget_turret(e);
     }
+}
+
+static void timer_turret_fire(entity *e) {
+    const entity_info *info = E_INFO(e);
+    const f32 bpt = turret_bullets_per_tick(e);
+    const u64 now = state->time.tick;
+    if (state->stage != STAGE_PLAY || e->health <= 0) { return; }
+
+    level_schedule(
+        state->level, e, ENTITY_TIMER_FIRE, 0,
+        next_cadence(now, e->id.index, bpt));
+
+    // cannons pick the best target for every shell
+    entity *target =
+        info->turret.is_cannon ?
+            retarget_turret(e)
+            : level_get_entity(state->level, e->turret.target);
+    if (!target) { return; }
+
+    vec2s origin;
+    const vec2s dir = aim_turret(e, target, &origin);
 
-    // only find target every 5 ticks
-    if ((e->id.index + state->time.tick) % 5) {
-        goto shoot;
+    const int n = cadence(now, e->id.index, bpt);
+    for (int i = 0; i < n; i++) {
+        shoot_bullet(info->turret.bullet, origin, dir, target->tile);
     }
+}
 
-new_target:
-    target =
-        level_find_nearest_entity(
-            state->level, e->tile, (f_entity_priority) priority_turret_target, e);
-    e->turret.target = target ? target->id : ENTITY_NONE;
+// finding targets and shooting run off timers, ticks only aim
+static void tick_turret(entity *e) {
+    // catch up on idle spinning missed while asleep
+    if (e->sleep_tick != 0) {
+        e->turret.angle +=
+            TURRET_IDLE_SPIN * (state->time.tick - 1 - e->sleep_tick);
+        e->sleep_tick = 0;
+    }
 
-shoot:
-    if (!target) {
-        // twist idly
-        e->turret.angle += 0.1f;
+    if (state->stage != STAGE_PLAY) {
+        e->turret.angle += TURRET_IDLE_SPIN;
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
         return;
     }
 
-    const vec2s
-        origin = (vec2s) {{ e->pos.x + 4, e->pos.y + 5 }},
-        dir = glms_vec2_normalize(glms_vec2_sub(IVEC2S2V(entity_center(target)), origin));
-
-    e->turret.angle = -atan2f(dir.y, dir.x);
+    if (check_building_death(e)) { return; }
+    arm_turret(e);
 
-    for (int i = 0; i < n_shoot; i++) {
-        shoot_bullet(info->turret.bullet, origin, dir, target->tile);
+    // the shared target map makes looking again as soon as a target dies
+    // cheap
+    const entity *target = level_get_entity(state->level, e->turret.target);
+    if (!target) { target = retarget_turret(e); }
+    if (!target) {
+        // twist idly until the retarget timer finds something
+        e->turret.angle += TURRET_IDLE_SPIN;
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+        return;
     }
+
+    vec2s origin;
+    aim_turret(e, target, &origin);
 }
 
 static void tick_basic_building(entity *e) {
-    if (state->stage != STAGE_PLAY) { return; }
-    if (check_building_death(e)) { return; }
+    if (state->stage == STAGE_PLAY && check_building_death(e)) { return; }
+
+    // nothing to do until damaged or the stage changes
+    level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
 }
 
 static void tick_truck(entity *e) {
-    if (state->stage != STAGE_PLAY) { return; }
+    if (state->stage != STAGE_PLAY) {
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+        return;
+    }
 
-    e->health = max(e->health, 0);
-    state->stats.truck_health = e->health;
+    entity_set_health(e, max(e->health, 0));
+    level_push_command(
+        state->level,
+        (level_command) {
+            .type = LEVEL_COMMAND_TRUCK_HEALTH,
+            .truck_health = e->health
+        });
 
     if (e->health < e->last_health && (state->time.tick % 5 == 0)) {
         play_hit_sound();
@@ -343,7 +441,12 @@ static void tick_truck(entity *e) {
 
     if (e->health <= 0) {
         sound_play("lose.wav", 1.0f);
-        state_set_stage(state, STAGE_DONE);
+        level_push_command(
+            state->level,
+            (level_command) {
+                .type = LEVEL_COMMAND_STAGE,
+                .stage = STAGE_DONE
+            });
     }
 
     if (!e->path) {
@@ -383,7 +486,13 @@ static void tick_truck(entity *e) {
         }
 
         if (e->truck.path_index == dynlist_size(e->path)) {
-            state_set_stage(state, STAGE_DONE);
+            level_push_command(
+                state->level,
+                (level_command) {
+                    .type = LEVEL_COMMAND_STAGE,
+                    .stage = STAGE_DONE
+                });
+            return;
         }
 
         entity_move_to_point(e, IVEC2S2V(goal_px), false, speed, &e->last_move, &e->truck.dir);
@@ -406,25 +515,45 @@ static bool check_enemy_death(entity *e) {
             palette_get(info->palette),
             TICKS_PER_SECOND,
             3, 5, false);
-        state->stats.money += info->enemy.bounty;
+        level_push_command(
+            state->level,
+            (level_command) {
+                .type = LEVEL_COMMAND_MONEY,
+                .money = info->enemy.bounty
+            });
         return true;
     }
 
     return false;
 }
 
-void tick_boombox(entity *e) {
-    tick_basic_building(e);
+// ticks between music particles
+#define BOOMBOX_MUSIC_TICKS 35
+
+static void timer_boombox_music(entity *e) {
+    level_schedule(
+        state->level, e, ENTITY_TIMER_MUSIC, 0,
+        next_period(
+            state->time.tick, e->id.index * 13, BOOMBOX_MUSIC_TICKS));
 
-    if (((e->id.index * 13) + state->time.tick) % 35 == 0) {
+    if (!governor_shed(&state->gov, GOV_SHED_MUSIC_PARTICLES)) {
         particle_new_music(
             IVEC2S2V(entity_center(e)), 40);
     }
 }
 
+void tick_boombox(entity *e) {
+    arm(e, ENTITY_TIMER_MUSIC, 0,
+        next_period(state->time.tick, e->id.index * 13, BOOMBOX_MUSIC_TICKS));
+
+    if (state->stage == STAGE_PLAY && check_building_death(e)) { return; }
+
+    // music particles run off a timer
+    level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+}
+
 int priority_alien_target(entity *e, entity *alien) {
-    const entity_info *info = E_INFO(e);
-    if (e->type != ENTITY_TRUCK && !(info->flags & EIF_PLACEABLE)) {
+    if (e->type != ENTITY_TRUCK && !(E_FLAGS(e) & EIF_PLACEABLE)) {
         return -1;
     }
 
@@ -435,11 +564,8 @@ int priority_alien_target(entity *e, entity *alien) {
         mod = 4.8f;
     } else {
         // check for other aliens on tile, don't mob
-        entity *entities[64];
-        const int n =
-            level_get_tile_entities(state->level, e->tile, entities, 64);
-        for (int i = 0; i < n; i++) {
-            if (E_INFO(entities[i])->flags & EIF_ENEMY) {
+        level_tile_each(state->level, e->tile, it) {
+            if (E_FLAGS(it.el) & EIF_ENEMY) {
                 mod = max(mod - 0.25f, 0.1f);
             }
         }
@@ -452,6 +578,11 @@ int priority_alien_target(entity *e, entity *alien) {
     return mod * invdist;
 }
 
+// at least (r - 1) tiles away, at most the truck's 5x
+static int bound_alien_target(int r, entity*) {
+    return 5.0f * (512.0f - (max(r - 1, 0) * TILE_SIZE_PX));
+}
+
 static int alien_path_weight(const level *l, ivec2s p, entity *e) {
     if (!level_tile_in_bounds(p)) {
         return -1;
@@ -474,10 +605,31 @@ static int alien_path_weight(const level *l, ivec2s p, entity *e) {
     return base + (l->music_level[p.x][p.y] * 10);
 }
 
+// ticks between repaths
+#define ALIEN_REPATH_TICKS 5
+
+// drops the path, the next tick paths again
+static void timer_alien_repath(entity *e) {
+    if (state->stage != STAGE_PLAY) { return; }
+
+    level_schedule(
+        state->level, e, ENTITY_TIMER_REPATH, 0,
+        next_period(state->time.tick, e->id.index, ALIEN_REPATH_TICKS));
+
+    dynlist_free(e->path);
+    e->path = NULL;
+}
+
 void tick_alien(entity *e) {
     e->last_move = VEC2S(0);
 
-    if (state->stage != STAGE_PLAY) { return; }
+    if (state->stage != STAGE_PLAY) {
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+        return;
+    }
+
+    arm(e, ENTITY_TIMER_REPATH, 0,
+        next_period(state->time.tick, e->id.index, ALIEN_REPATH_TICKS));
 
     const entity_info *info = &ENTITY_INFO[e->type];
     if (check_enemy_death(e)) { return; }
@@ -485,20 +637,24 @@ void tick_alien(entity *e) {
     entity *target = level_get_entity(state->level, e->alien.target);
     if (target) { goto path; }
 
-    target =
-        level_find_nearest_entity(
+    const int n =
+        level_query_nearest(
             state->level, e->tile,
-            (f_entity_priority) priority_alien_target,
-            e);
+            &(level_query) {
+                .radius = -1,
+                .priority = (f_entity_priority) priority_alien_target,
+                .bound = (f_entity_priority_bound) bound_alien_target,
+                .userdata = e,
+            },
+            &target, 1);
+    if (!n) { target = NULL; }
     e->alien.target = target ? target->id : ENTITY_NONE;
 
     if (!target) { return; }
 
-    // only path for aliens once every 5 ticks
+    // the repath timer drops the path
 path:
-    if (e->path && ((e->id.index + state->time.tick) % 5) != 0) {
-        goto move;
-    }
+    if (e->path) { goto move; }
 
     ASSERT(target);
 
@@ -547,7 +703,7 @@ move:
         dps *= 1.0f - (state->stats.truck_armor_level * 0.25f);
         dps = max(dps, 0);
 
-        target->health -= dps / TICKS_PER_SECOND;
+        damage_entity(target, dps / TICKS_PER_SECOND);
 
         // particle
         if ((state->time.tick + e->id.index * 13) % 20 == 0) {
@@ -562,61 +718,116 @@ move:
     e->alien.dir = dir;
 }
 
-void tick_ship(entity *e) {
-    if (state->stage != STAGE_PLAY) { return; }
+static f32 ship_spawns_per_tick(const entity *e, int i) {
+    return E_INFO(e)->ship.spawns[i].spawns_per_second / TICKS_PER_SECOND;
+}
 
+// spawn slot i's cadence is offset per ship and slot
+static int ship_spawn_offset(const entity *e, int i) {
+    return i * e->id.index * 13;
+}
+
+static void timer_ship_spawn(entity *e, int i) {
     const entity_info *info = E_INFO(e);
+    const f32 spt = ship_spawns_per_tick(e, i);
+    const int offset = ship_spawn_offset(e, i);
+    const u64 now = state->time.tick;
 
-    if (check_enemy_death(e)) { return; }
+    // ships never see another STAGE_PLAY
+    if (state->stage != STAGE_PLAY || e->health <= 0) { return; }
 
-    if (e->ticks_alive < TICKS_PER_SECOND) {
-        if (e->ticks_alive == 0) {
-            sound_play("ship.wav", 1.0f);
+    level_schedule(
+        state->level, e, ENTITY_TIMER_SPAWN, i,
+        next_cadence(now, offset, spt));
+
+    const int n = cadence(now, offset, spt);
+    struct rand r = rand_create(now + e->id.index);
+
+    for (int j = 0; j < n; j++) {
+        if (!rand_chance(&r, info->ship.spawns[i].chance)) {
+            continue;
         }
 
+        const f32 a = rand_f64(&r, 0, TAU);
+        const entity_type type = info->ship.spawns[i].spawn_type;
+        const vec2s pos =
+            glms_vec2_add(
+                e->pos, glms_vec2_scale(VEC2S(cos(a), sin(a)), 5.0f));
+        level_push_command(
+            state->level,
+            (level_command) {
+                .type = LEVEL_COMMAND_SPAWN,
+                .spawn = { .type = type, .pos = pos }
+            });
+        sound_play("spawn.wav", 1.0f);
+
         particle_new_fancy(
-            IVEC2S2V(entity_center(e)),
+            IVEC2S2V(
+                aabb_center(
+                    aabb_translate(ENTITY_HOT[type].aabb, VEC2S2I(pos)))),
             palette_get(PALETTE_LIGHT_BLUE),
-            20);
-    } else {
+            4);
+    }
+}
+
+// spawning runs off timers once faded in, ticks only fade in
+void tick_ship(entity *e) {
+    if (state->stage != STAGE_PLAY) {
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+        return;
+    }
+
+    const entity_info *info = E_INFO(e);
+
+    if (check_enemy_death(e)) { return; }
+
+    if (e->ticks_alive == 0) {
+        sound_play("ship.wav", 1.0f);
+
+        // first spawns once faded in
+        const u64 faded = state->time.tick + TICKS_PER_SECOND - 1;
         for (int i = 0; i < (int) ARRLEN(info->ship.spawns); i++) {
             if (info->ship.spawns[i].spawn_type == ENTITY_TYPE_NONE) {
                 break;
             }
 
-            const f32 spt =
-                info->ship.spawns[i].spawns_per_second / TICKS_PER_SECOND;
-            const int t = (i * e->id.index * 13) + state->time.tick;
-            const int n =
-                ((int) (floorf(t * spt))) - ((int) (floorf((t - 1) * spt)));
+            const f32 spt = ship_spawns_per_tick(e, i);
+            if (spt <= 0.0f) { continue; }
 
-            struct rand r = rand_create(state->time.tick + e->id.index);
+            level_schedule(
+                state->level, e, ENTITY_TIMER_SPAWN, i,
+                next_cadence(faded, ship_spawn_offset(e, i), spt));
+        }
+    }
 
-            for (int j = 0; j < n; j++) {
-                if (!rand_chance(&r, info->ship.spawns[i].chance)) {
-                    continue;
-                }
+    if (e->ticks_alive < TICKS_PER_SECOND) {
+        particle_new_fancy(
+            IVEC2S2V(entity_center(e)),
+            palette_get(PALETTE_LIGHT_BLUE),
+            20);
+    }
 
-                const f32 a = rand_f64(&r, 0, TAU);
-                entity *alien =
-                    level_new_entity(state->level, info->ship.spawns[i].spawn_type);
-                entity_set_pos(
-                    alien,
-                    glms_vec2_add(
-                        e->pos, glms_vec2_scale(VEC2S(cos(a), sin(a)), 5.0f)));
-                sound_play("spawn.wav", 1.0f);
-
-            particle_new_fancy(
-                IVEC2S2V(entity_center(alien)),
-                palette_get(PALETTE_LIGHT_BLUE),
-                4);
-            }
-        }
+    if (e->ticks_alive >= TICKS_PER_SECOND - 1) {
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
     }
 }
 
 void tick_bullet(entity *e) {
-    if (state->stage != STAGE_PLAY) { return; }
+    if (state->stage != STAGE_PLAY) {
+        level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+        return;
+    }
+
+    entity_set_pos(
+        e,
+        glms_vec2_add(
+            e->pos,
+            glms_vec2_scale(
+                e->bullet.velocity, 1.0f / TICKS_PER_SECOND)));
+
+    // moved out of the level, deleted by level_tick. px rather than tile,
+    // which is clamped to the level.
+    if (!level_px_in_bounds(e->px)) { return; }
 
     bool done = false;
     if (state->level->tiles[e->tile.x][e->tile.y] == TILE_MOUNTAIN) {
@@ -641,43 +852,31 @@ void tick_bullet(entity *e) {
 
         const aabb box = entity_aabb(e);
 
-        entity *entities[256];
-        const int ncol = find_collisions(&box, entities, 256);
-
-        for (int i = 0; i < ncol; i++) {
-            entity *f = entities[i];
-            const entity_info *f_info = &ENTITY_INFO[f->type];
-            if (f_info->flags & EIF_ENEMY) {
-                f->health -= 1.0f;
-                e->delete = true;
-                particle_new_splat(
-                    IVEC2S2V(entity_center(f)),
-                    palette_get(f_info->palette),
-                    10);
-                break;
-            }
+        level_enemy_box_each(state->level, &box, it) {
+            entity *f = it.el;
+            damage_entity(f, 1.0f);
+            e->delete = true;
+            particle_new_splat(
+                IVEC2S2V(entity_center(f)),
+                palette_get(E_HOT(f)->palette),
+                10);
+            break;
         }
     }
 }
 
-static void update_bullet(entity *e, f32 dt) {
-    if (state->stage != STAGE_PLAY) { return; }
-
-    entity_set_pos(
-        e,
-        (vec2s) {{
-            e->pos.x + e->bullet.velocity.x * dt,
-            e->pos.y + e->bullet.velocity.y * dt,
-        }});
+// base sprite index from the hot table
+static ivec2s base_sprite(const entity *e) {
+    return IVEC2S(E_HOT(e)->base_sprite[0], E_HOT(e)->base_sprite[1]);
 }
 
 static void draw_basic(entity *e) {
-    ivec2s index = ENTITY_INFO[e->type].base_sprite;
+    ivec2s index = base_sprite(e);
     gfx_batcher_push_sprite(
         &state->batcher,
         &state->atlas.tile,
         &(gfx_sprite) {
-            .pos = {{ e->px.x, e->px.y }},
+            .pos = IVEC2S2V(entity_draw_px(e)),
             .index = index,
             .color = {{ 1.0f, 1.0f, 1.0f, 1.0f }},
             .z = Z_LEVEL_ENTITY,
@@ -686,12 +885,12 @@ static void draw_basic(entity *e) {
 }
 
 static void draw_ship(entity *e) {
-    ivec2s index = ENTITY_INFO[e->type].base_sprite;
+    ivec2s index = base_sprite(e);
     gfx_batcher_push_sprite(
         &state->batcher,
         &state->atlas.tile,
         &(gfx_sprite) {
-            .pos = {{ e->px.x, e->px.y }},
+            .pos = IVEC2S2V(entity_draw_px(e)),
             .index = index,
             .color = GRAYSCALE(1.0f, e->ticks_alive / (f32) TICKS_PER_SECOND),
             .z = Z_LEVEL_ENTITY,
@@ -700,7 +899,7 @@ static void draw_ship(entity *e) {
 }
 
 static void draw_truck(entity *e) {
-    const ivec2s index = ENTITY_INFO[e->type].base_sprite;
+    const ivec2s index = base_sprite(e);
 
     ivec2s offset;
     switch (e->truck.dir) {
@@ -715,7 +914,7 @@ static void draw_truck(entity *e) {
         &state->batcher,
         &state->atlas.tile,
         &(gfx_sprite) {
-            .pos = {{ e->px.x, e->px.y }},
+            .pos = IVEC2S2V(entity_draw_px(e)),
             .index = glms_ivec2_add(index, offset),
             .color = {{ 1.0f, 1.0f, 1.0f, 1.0f }},
             .z = Z_LEVEL_ENTITY,
@@ -737,9 +936,9 @@ static void draw_truck(entity *e) {
 }
 
 static void draw_health(entity *e) {
-    if (state->stage == STAGE_BUILD) { return; }
+    if (state->render->stage == STAGE_BUILD) { return; }
 
-    const int max = max(E_INFO(e)->max_health, 1);
+    const int max = max(E_HOT(e)->max_health, 1);
     const f32 u = e->health / (f32) max;
 
     gfx_batcher_push_subimage(
@@ -767,9 +966,16 @@ static void draw_turret(entity *e) {
     draw_basic(e);
     draw_health(e);
 
+    // asleep turrets are still spinning idly
+    const f32 angle =
+        e->turret.angle
+            + (e->asleep ?
+                TURRET_IDLE_SPIN * (state->render->tick - e->sleep_tick)
+                : 0.0f);
+
     const int nframes = 6;
     const int i =
-        ((int) roundf(wrap_angle(e->turret.angle + PI) / (TAU / nframes))) % nframes;
+        ((int) roundf(wrap_angle(angle + PI) / (TAU / nframes))) % nframes;
     gfx_batcher_push_sprite(
         &state->batcher,
         &state->atlas.tile,
@@ -788,7 +994,9 @@ static void draw_radar(entity *e) {
     draw_basic(e);
     draw_health(e);
 
-    if (glms_ivec2_eq(state->input.cursor.tile, e->tile)) {
+    const bool overlays = !governor_shed(&state->gov, GOV_SHED_RADAR);
+
+    if (overlays && glms_ivec2_eq(state->input.cursor.tile, e->tile)) {
         const int r = E_INFO(e)->radar.radius;
         for (int x = -r; x <= r; x++) {
             for (int y = -r; y <= r; y++) {
@@ -812,7 +1020,7 @@ static void draw_radar(entity *e) {
         }
     }
 
-    if (state->stage == STAGE_BUILD) {
+    if (overlays && state->render->stage == STAGE_BUILD) {
         // show potential alien spawns
         const int r = E_INFO(e)->radar.radius;
         for (int x = -r; x <= r; x++) {
@@ -832,7 +1040,7 @@ static void draw_radar(entity *e) {
                     Z_LEVEL_ENTITY_OVERLAY,
                     VEC4S(
                         col.r, col.g, col.b,
-                        0.2f + 0.5f * fabsf(sinf(state->time.tick / 8.0f))),
+                        0.2f + 0.5f * fabsf(sinf(state->render->tick / 8.0f))),
                     FONT_DOUBLED,
                     "?");
             }
@@ -840,7 +1048,7 @@ static void draw_radar(entity *e) {
     }
 
     // blinky bit
-    if ((((e->id.index * 17) + state->time.tick / 5)) % 6 == 0) { return; }
+    if ((((e->id.index * 17) + state->render->tick / 5)) % 6 == 0) { return; }
 
     gfx_batcher_push_sprite(
         &state->batcher,
@@ -855,11 +1063,11 @@ static void draw_radar(entity *e) {
 }
 
 static void draw_alien(entity *e) {
-    entity_info *info = &ENTITY_INFO[e->type];
-    const ivec2s base = info->base_sprite;
+    const entity_hot_info *info = E_HOT(e);
+    const ivec2s base = base_sprite(e);
     const int i =
         glms_vec2_norm(e->last_move) > 0.0001f ?
-            (((int) roundf(state->time.tick / (4 / info->enemy.speed))) % 2)
+            (((int) roundf(state->render->tick / (4 / info->speed))) % 2)
             : 0;
     ivec2s index_offset, sprite_offset = (ivec2s) {{ 0, 0 }};
     int flags = GFX_NO_FLAGS;
@@ -887,7 +1095,7 @@ static void draw_alien(entity *e) {
     default: ASSERT(false);
     }
 
-    vec4s color = palette_get(E_INFO(e)->palette);
+    vec4s color = palette_get(info->palette);
 
     if (e->type == ENTITY_ALIEN_GHOST) {
         color.a = 0.6f;
@@ -897,7 +1105,7 @@ static void draw_alien(entity *e) {
         &state->batcher,
         &state->atlas.tile,
         &(gfx_sprite) {
-            .pos = glms_vec2_add(e->pos, IVEC2S2V(sprite_offset)),
+            .pos = glms_vec2_add(entity_draw_pos(e), IVEC2S2V(sprite_offset)),
             .index = glms_ivec2_add(base, index_offset),
             .color = color,
             .z = Z_LEVEL_ENTITY_OVERLAY,
@@ -921,9 +1129,12 @@ static void draw_alien(entity *e) {
 static bool can_place_basic(ivec2s tile) {
     if (!level_tile_in_bounds(tile)) { return false; }
 
-    dlist_each(tile_node, &state->level->tile_entities[tile.x][tile.y], it) {
-        const int flags = ENTITY_INFO[it.el->type].flags;
-        if (!(flags & EIF_DOES_NOT_BLOCK)) {
+    level *l = state->level;
+
+    int n;
+    const u16 *cell = level_tile_grid(l, tile, &n);
+    for (int i = 0; i < n; i++) {
+        if (!(E_FLAGS(level_entity_at(l, cell[i])) & EIF_DOES_NOT_BLOCK)) {
             return false;
         }
     }
@@ -936,16 +1147,54 @@ static bool can_place_basic(ivec2s tile) {
     return false;
 }
 
+// for types with no tick/draw in ENTITY_TYPES
+// nothing to tick, sleep for good
+static void tick_none(entity *e) {
+    level_sleep_entity(state->level, e, LEVEL_WAKE_DAMAGE);
+}
+static void draw_none(entity*) {}
+
+void entity_timer_fire(entity *e, entity_timer action, int arg) {
+    switch (action) {
+    case ENTITY_TIMER_RETARGET: timer_turret_retarget(e); break;
+    case ENTITY_TIMER_FIRE: timer_turret_fire(e); break;
+    case ENTITY_TIMER_REPATH: timer_alien_repath(e); break;
+    case ENTITY_TIMER_MUSIC: timer_boombox_music(e); break;
+    case ENTITY_TIMER_SPAWN: timer_ship_spawn(e, arg); break;
+    }
+}
+
+void entity_tick_span(entity_store *s, entity_type type, int start, int end) {
+    switch (type) {
+#define TICK_CASE(_n, _name, _t, _d, _f)                                     \
+    case ENTITY_##_n:                                                        \
+        for (int i = start; i < end; i++) {                                  \
+            entity *e = s->entity[i];                                        \
+            if (!e->delete) { tick_##_t(e); }                                \
+        }                                                                    \
+        break;
+    ENTITY_TYPES(TICK_CASE)
+#undef TICK_CASE
+    default: break;
+    }
+}
+
+void entity_draw(entity *e) {
+    switch (e->type) {
+#define DRAW_CASE(_n, _name, _t, _d, _f) case ENTITY_##_n: draw_##_d(e); break;
+    ENTITY_TYPES(DRAW_CASE)
+#undef DRAW_CASE
+    default: break;
+    }
+}
+
 entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_TURRET_L0] = {
         .name = "TURRET MK. 1",
         .base_sprite = {{ 0, 5 }},
-        .draw = draw_turret,
-        .tick = tick_turret,
         .unlock_price = 0,
         .buy_price = 50,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .turret = {
             .bullet = ENTITY_BULLET_L0,
             .bps = 4.2f,
@@ -963,12 +1212,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_TURRET_L1] = {
         .name = "TURRET MK. 2",
         .base_sprite = {{ 1, 5 }},
-        .draw = draw_turret,
-        .tick = tick_turret,
         .unlock_price = 400,
         .buy_price = 175,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .turret = {
             .bullet = ENTITY_BULLET_L1,
             .bps = 7.0f,
@@ -986,12 +1232,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_TURRET_L2] = {
         .name = "TURRET MK. 3",
         .base_sprite = {{ 2, 5 }},
-        .draw = draw_turret,
-        .tick = tick_turret,
         .unlock_price = 1000,
         .buy_price = 275,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .turret = {
             .bullet = ENTITY_BULLET_L2,
             .bps = 10.0f,
@@ -1009,12 +1252,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_CANNON_L0] = {
         .name = "CANNON MK. 1",
         .base_sprite = {{ 3, 7 }},
-        .draw = draw_turret,
-        .tick = tick_turret,
         .unlock_price = 500,
         .buy_price = 175,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .turret = {
             .bullet = ENTITY_SHELL_L0,
             .bps = 0.7f,
@@ -1033,12 +1273,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_CANNON_L1] = {
         .name = "CANNON MK. 2",
         .base_sprite = {{ 4, 7 }},
-        .draw = draw_turret,
-        .tick = tick_turret,
         .unlock_price = 1000,
         .buy_price = 250,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .turret = {
             .bullet = ENTITY_SHELL_L1,
             .bps = 1.5f,
@@ -1057,12 +1294,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_MINE_L0] = {
         .name = "MINE MK. 1",
         .base_sprite = {{ 3, 4 }},
-        .draw = draw_basic,
-        .tick = tick_mine,
         .unlock_price = 200,
         .buy_price = 150,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE | EIF_CAN_SPAWN,
         .aabb = {
             .min = {{ 0, 2 }},
             .max = {{ 6, 4 }}
@@ -1072,12 +1306,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_MINE_L1] = {
         .name = "MINE MK. 2",
         .base_sprite = {{ 4, 4 }},
-        .draw = draw_basic,
-        .tick = tick_mine,
         .unlock_price = 400,
         .buy_price = 200,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE | EIF_CAN_SPAWN,
         .aabb = {
             .min = {{ 0, 2 }},
             .max = {{ 6, 4 }}
@@ -1087,12 +1318,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_MINE_L2] = {
         .name = "MINE MK. 3",
         .base_sprite = {{ 5, 4 }},
-        .draw = draw_basic,
-        .tick = tick_mine,
         .unlock_price = 1000,
         .buy_price = 400,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE | EIF_CAN_SPAWN,
         .aabb = {
             .min = {{ 0, 2 }},
             .max = {{ 6, 4 }}
@@ -1102,12 +1330,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_RADAR_L0] = {
         .name = "RADAR MK. 1",
         .base_sprite = {{ 3, 5 }},
-        .tick = tick_basic_building,
-        .draw = draw_radar,
         .unlock_price = 150,
         .buy_price = 100,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .aabb = {
             .min = {{ 1, 0 }},
             .max = {{ 5, 5 }}
@@ -1124,12 +1349,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_RADAR_L1] = {
         .name = "RADAR MK. 2",
         .base_sprite = {{ 4, 5 }},
-        .tick = tick_basic_building,
-        .draw = draw_radar,
         .unlock_price = 500,
         .buy_price = 250,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .aabb = {
             .min = {{ 1, 0 }},
             .max = {{ 5, 5 }}
@@ -1146,12 +1368,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_DECOY_TRUCK] = {
         .name = "DECOY TRUCK",
         .base_sprite = {{ 6, 0 }},
-        .tick = tick_basic_building,
-        .draw = draw_basic,
         .unlock_price = 250,
         .buy_price = 150,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .aabb = {
             .min = {{ 1, 1 }},
             .max = {{ 7, 6 }}
@@ -1165,12 +1384,9 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     [ENTITY_BOOMBOX] = {
         .name = "BOOMBOX",
         .base_sprite = {{ 3, 3 }},
-        .tick = tick_boombox,
-        .draw = draw_basic,
         .unlock_price = 500,
         .buy_price = 200,
         .can_place = can_place_basic,
-        .flags = EIF_PLACEABLE,
         .aabb = {
             .min = {{ 1, 0 }},
             .max = {{ 5, 5 }}
@@ -1183,10 +1399,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_BULLET_L0] = {
         .base_sprite = {{ 0, 7 }},
-        .draw = draw_basic,
-        .tick = tick_bullet,
-        .update = update_bullet,
-        .flags = EIF_DOES_NOT_BLOCK,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 1, 1 }}
@@ -1198,10 +1410,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_BULLET_L1] = {
         .base_sprite = {{ 0, 7 }},
-        .draw = draw_basic,
-        .tick = tick_bullet,
-        .update = update_bullet,
-        .flags = EIF_DOES_NOT_BLOCK,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 1, 1 }}
@@ -1213,10 +1421,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_BULLET_L2] = {
         .base_sprite = {{ 0, 7 }},
-        .draw = draw_basic,
-        .tick = tick_bullet,
-        .update = update_bullet,
-        .flags = EIF_DOES_NOT_BLOCK,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 1, 1 }}
@@ -1228,10 +1432,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_SHELL_L0] = {
         .base_sprite = {{ 2, 7 }},
-        .draw = draw_basic,
-        .tick = tick_bullet,
-        .update = update_bullet,
-        .flags = EIF_DOES_NOT_BLOCK,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 2, 2 }}
@@ -1244,10 +1444,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_SHELL_L1] = {
         .base_sprite = {{ 2, 7 }},
-        .draw = draw_basic,
-        .tick = tick_bullet,
-        .update = update_bullet,
-        .flags = EIF_DOES_NOT_BLOCK,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 2, 2 }}
@@ -1260,13 +1456,10 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_FLAG] = {
         .base_sprite = {{ 7, 1 }},
-        .draw = draw_basic,
 
     },
     [ENTITY_TRUCK] = {
         .base_sprite = {{ 3, 1 }},
-        .draw = draw_truck,
-        .tick = tick_truck,
         .palette = 12,
         .aabb = {
             .min = {{ 1, 1 }},
@@ -1278,9 +1471,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_ALIEN_L0] = {
         .base_sprite = {{ 0, 10 }},
-        .draw = draw_alien,
-        .tick = tick_alien,
-        .flags = EIF_ENEMY | EIF_ALIEN,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 4, 4 }}
@@ -1297,9 +1487,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_ALIEN_L1] = {
         .base_sprite = {{ 0, 10 }},
-        .draw = draw_alien,
-        .tick = tick_alien,
-        .flags = EIF_ENEMY | EIF_ALIEN,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 4, 4 }}
@@ -1316,9 +1503,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_ALIEN_L2] = {
         .base_sprite = {{ 0, 10 }},
-        .draw = draw_alien,
-        .tick = tick_alien,
-        .flags = EIF_ENEMY | EIF_ALIEN,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 4, 4 }}
@@ -1335,9 +1519,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_ALIEN_FAST] = {
         .base_sprite = {{ 0, 10 }},
-        .draw = draw_alien,
-        .tick = tick_alien,
-        .flags = EIF_ENEMY | EIF_ALIEN,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 4, 4 }}
@@ -1354,9 +1535,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_ALIEN_TANK] = {
         .base_sprite = {{ 0, 10 }},
-        .draw = draw_alien,
-        .tick = tick_alien,
-        .flags = EIF_ENEMY | EIF_ALIEN,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 4, 4 }}
@@ -1373,9 +1551,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_ALIEN_GHOST] = {
         .base_sprite = {{ 0, 10 }},
-        .draw = draw_alien,
-        .tick = tick_alien,
-        .flags = EIF_ENEMY | EIF_ALIEN,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 4, 4 }}
@@ -1392,9 +1567,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_SHIP_L0] = {
         .base_sprite = {{ 0, 8 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 7, 5 }}
@@ -1416,9 +1588,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_SHIP_L1] = {
         .base_sprite = {{ 1, 8 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 7, 5 }}
@@ -1441,9 +1610,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_SHIP_L2] = {
         .base_sprite = {{ 1, 8 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 7, 5 }}
@@ -1469,9 +1635,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_TRANSPORT_L0] = {
         .base_sprite = {{ 0, 9 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 6, 6 }}
@@ -1495,9 +1658,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_TRANSPORT_L1] = {
         .base_sprite = {{ 1, 9 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 6, 6 }}
@@ -1522,9 +1682,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_TRANSPORT_L2] = {
         .base_sprite = {{ 2, 9 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 6, 6 }}
@@ -1549,9 +1706,6 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
     },
     [ENTITY_FLAGSHIP] = {
         .base_sprite = {{ 3, 9 }},
-        .draw = draw_ship,
-        .tick = tick_ship,
-        .flags = EIF_ENEMY | EIF_SHIP,
         .aabb = {
             .min = {{ 0, 0 }},
             .max = {{ 6, 6 }}
@@ -1580,20 +1734,40 @@ entity_info ENTITY_INFO[ENTITY_TYPE_COUNT] = {
         .base_sprite = {{ 7, 0 }},
         .unlock_price = 0,
         .buy_price = 100,
-        .flags = EIF_NOT_AN_ENTITY
     },
     [ENTITY_ARMOR_UPGRADE] = {
         .name = "+TRUCK ARMOR",
         .base_sprite = {{ 8, 0 }},
         .unlock_price = 0,
         .buy_price = 1000,
-        .flags = EIF_NOT_AN_ENTITY
     },
     [ENTITY_SPEED_UPGRADE] = {
         .name = "+TRUCK SPEED",
         .base_sprite = {{ 9, 0 }},
         .unlock_price = 0,
         .buy_price = 1000,
-        .flags = EIF_NOT_AN_ENTITY
     }
 };
+
+entity_hot_info ENTITY_HOT[ENTITY_TYPE_COUNT] __attribute__((aligned(64)));
+
+void entity_info_init() {
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++) {
+        entity_info *info = &ENTITY_INFO[i];
+        info->flags = entity_type_flags(i);
+
+        ASSERT(
+            info->max_health <= INT16_MAX
+            && info->palette < 256
+            && info->base_sprite.x < 256
+            && info->base_sprite.y < 256);
+
+        ENTITY_HOT[i] = (entity_hot_info) {
+            .aabb = info->aabb,
+            .speed = info->enemy.speed,
+            .max_health = info->max_health,
+            .palette = info->palette,
+            .base_sprite = { info->base_sprite.x, info->base_sprite.y },
+        };
+    }
+}
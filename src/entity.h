@@ -9,6 +9,10 @@
 #include "direction.h"
 
 #define E_INFO(_p) (&ENTITY_INFO[(_p)->type])
+#define E_HOT(_p) (&ENTITY_HOT[(_p)->type])
+#define E_FLAGS(_p) entity_type_flags((_p)->type)
+
+typedef struct entity_store_s entity_store;
 
 typedef struct entity_s {
     entity_id id;
@@ -18,6 +22,10 @@ typedef struct entity_s {
     ivec2s px;
     ivec2s tile;
 
+    // pos at the start of the last tick, drawn positions are interpolated
+    // from here to pos
+    vec2s prev_pos;
+
     vec2s last_move;
     f32 health, last_health;
     int ticks_alive;
@@ -47,26 +55,47 @@ typedef struct entity_s {
 
     bool delete;
 
-    // see level.h
-    DLIST_NODE(struct entity_s) node;
+    // index into level::hot, see entity_store.h
+    int slot;
 
+    // false until first positioned
     bool on_tile;
-    DLIST_NODE(struct entity_s) tile_node;
+
+    // index into level::enemy_boxes, -1 until the grid is next rebuilt for
+    // enemies and always for everything else
+    int enemy_box;
+
+    // see level::type_entities
+    DLIST_NODE(struct entity_s) type_node;
+
+    // see level_sleep_entity. sleep_list indexes level::sleepers, sleep_tick
+    // is the tick the entity last went to sleep on.
+    bool asleep;
+    int sleep_list;
+    u64 sleep_tick;
+    DLIST_NODE(struct entity_s) sleep_node;
+
+    // (1 << ENTITY_TIMER_*) bits of actions scheduled on level::timers
+    u8 timers;
 } entity;
 
-typedef void (*f_entity_draw)(entity*);
-typedef void (*f_entity_tick)(entity*);
-typedef void (*f_entity_update)(entity*, f32);
+// periodic actions, scheduled on level::timers by entity ticks and
+// rescheduled by entity_timer_fire each time they are due (while they apply)
+typedef enum {
+    ENTITY_TIMER_RETARGET = 0, // turret without a target looks for one
+    ENTITY_TIMER_FIRE,         // turret shoots, cannons retarget first
+    ENTITY_TIMER_REPATH,       // alien drops its path
+    ENTITY_TIMER_MUSIC,        // boombox music particles
+    ENTITY_TIMER_SPAWN,        // ship spawns from ship.spawns[arg]
+} entity_timer;
+
 typedef bool (*f_entity_can_place)(ivec2s);
 
 typedef struct entity_info_s {
     const char *name;
     ivec2s base_sprite;
-    f_entity_draw draw;
-    f_entity_tick tick;
-    f_entity_update update;
     f_entity_can_place can_place;
-    int flags; // EIF_*
+    int flags; // EIF_*, set from ENTITY_TYPES by entity_info_init
     int unlock_price, buy_price;
 
     aabb aabb;
@@ -105,11 +134,35 @@ typedef struct entity_info_s {
     entity base;
 } entity_info;
 
+// the parts of entity_info read per entity in collision, targeting and draw
+// loops, packed two to a cache line. see entity_info_init.
+typedef struct {
+    aabb aabb;
+    f32 speed; // enemy.speed
+    i16 max_health;
+    u8 palette;
+    u8 base_sprite[2];
+} __attribute__((aligned(32))) entity_hot_info;
+
+STATIC_ASSERT(sizeof(entity_hot_info) == 32, "entity_hot_info is too big");
+
+// fills in ENTITY_INFO flags and builds ENTITY_HOT, call once at startup
+void entity_info_init();
+
 void entity_set_pos(entity*, vec2s);
+void entity_set_health(entity*, f32);
 aabb entity_aabb(const entity*);
 ivec2s entity_center(const entity *e);
-void entity_tick(entity*);
-void entity_update(entity*, f32 dt);
+vec2s entity_draw_pos(const entity *e);
+ivec2s entity_draw_px(const entity *e);
+// ticks s->entity[start, end), which are all of type and not yet deleted.
+// switch dispatched from ENTITY_TYPES so each type's tick is a direct call.
+void entity_tick_span(entity_store *s, entity_type type, int start, int end);
+
+// run a due timer action, called by level_tick before entities tick
+void entity_timer_fire(entity*, entity_timer, int arg);
+
 void entity_draw(entity*);
 
 extern entity_info ENTITY_INFO[ENTITY_TYPE_COUNT];
+extern entity_hot_info ENTITY_HOT[ENTITY_TYPE_COUNT];
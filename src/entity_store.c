@@ -0,0 +1,103 @@
+#include "entity_store.h"
+
+#include <cjam/log.h>
+
+#define FIELDS(_m)  \
+    _m(entity)      \
+    _m(type)        \
+    _m(index)       \
+    _m(pos)         \
+    _m(px)          \
+    _m(tile)        \
+    _m(health)      \
+    _m(asleep)
+
+// big enough for an element of any field
+typedef union {
+#define SCRATCH_FIELD(_f) TYPEOF(((entity_store*) NULL)->_f[0]) _f;
+    FIELDS(SCRATCH_FIELD)
+#undef SCRATCH_FIELD
+} scratch_element;
+
+void entity_store_destroy(entity_store *s) {
+#define FREE_FIELD(_f) free(s->_f);
+    FIELDS(FREE_FIELD)
+#undef FREE_FIELD
+    free(s->remap);
+    free(s->scratch);
+    *s = (entity_store) { 0 };
+}
+
+void entity_store_push(entity_store *s, entity *e) {
+    if (s->size == s->capacity) {
+        s->capacity = s->capacity == 0 ? 256 : (s->capacity * 2);
+#define GROW_FIELD(_f)                                                       \
+        s->_f = realloc(s->_f, s->capacity * sizeof(s->_f[0]));              \
+        ASSERT(s->_f);
+        FIELDS(GROW_FIELD)
+#undef GROW_FIELD
+
+        free(s->remap);
+        free(s->scratch);
+        s->remap = malloc(s->capacity * sizeof(int));
+        s->scratch = malloc(s->capacity * sizeof(scratch_element));
+    }
+
+    e->slot = s->size++;
+    s->entity[e->slot] = e;
+    entity_store_sync(s, e);
+    s->dirty = true;
+}
+
+void entity_store_remove(entity_store *s, entity *e) {
+    ASSERT(s->entity[e->slot] == e);
+    s->entity[e->slot] = NULL;
+    s->type[e->slot] = ENTITY_TYPE_NONE;
+    s->dirty = true;
+}
+
+void entity_store_compact(entity_store *s) {
+    if (!s->dirty) { return; }
+
+    // counting sort by (type, asleep), holes have type ENTITY_TYPE_NONE and
+    // are dropped
+#define BUCKET(_i) ((s->type[_i] * 2) + s->asleep[_i])
+    int next[ENTITY_TYPE_COUNT * 2] = { 0 };
+    for (int i = 0; i < s->size; i++) {
+        if (s->entity[i]) { next[BUCKET(i)]++; }
+    }
+
+    int n = 0;
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++) {
+        s->type_start[t] = n;
+        for (int b = t * 2; b < (t * 2) + 2; b++) {
+            const int m = next[b];
+            next[b] = n;
+            n += m;
+        }
+        s->type_awake[t] = next[(t * 2) + 1];
+    }
+    s->type_start[ENTITY_TYPE_COUNT] = n;
+
+    for (int i = 0; i < s->size; i++) {
+        s->remap[i] = s->entity[i] ? next[BUCKET(i)]++ : -1;
+    }
+#undef BUCKET
+
+#define SCATTER_FIELD(_f) {                                                  \
+        TYPEOF(s->_f[0]) *dst = s->scratch;                                  \
+        for (int i = 0; i < s->size; i++) {                                  \
+            if (s->remap[i] != -1) { dst[s->remap[i]] = s->_f[i]; }          \
+        }                                                                    \
+        memcpy(s->_f, dst, n * sizeof(s->_f[0]));                            \
+    }
+    FIELDS(SCATTER_FIELD)
+#undef SCATTER_FIELD
+
+    for (int i = 0; i < n; i++) {
+        s->entity[i]->slot = i;
+    }
+
+    s->size = n;
+    s->dirty = false;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cjam/types.h>
+#include <cjam/macros.h>
+
+#include "entity.h"
+
+// hot entity fields in dense parallel arrays (structure of arrays), so
+// whole-level passes stream through memory instead of chasing pointers.
+// entity::slot is an entity's index here, everything else (paths, behaviour
+// state, list nodes) stays in entity.
+//
+// entries are bucketed by type, type t's span is
+// [type_start[t], type_start[t + 1]). awake entities come first in each span,
+// up to type_awake[t], then asleep ones, each in spawn order. entities pushed
+// between ticks or by level_tick's spawn commands are appended past the spans
+// and sorted in by the entity_store_compact at the start of the next
+// level_tick.
+//
+// pos/px/tile are kept up to date by entity_set_pos, health by
+// entity_set_health, asleep by level_sleep_entity/level_wake_entity (which
+// leave the store dirty so the entity moves on the next compact) and type
+// never changes, nor does index.
+typedef struct entity_store_s {
+    int size, capacity;
+    int type_start[ENTITY_TYPE_COUNT + 1];
+    int type_awake[ENTITY_TYPE_COUNT];
+
+    // NULL (and type ENTITY_TYPE_NONE) for entities removed since the last
+    // entity_store_compact, only happens within level_tick
+    entity **entity;
+    entity_type *type;
+    u16 *index; // entity::id.index
+    vec2s *pos;
+    ivec2s *px, *tile;
+    f32 *health;
+    bool *asleep;
+
+    // true if there are holes or unsorted entries
+    bool dirty;
+
+    // for entity_store_compact
+    int *remap;
+    void *scratch;
+} entity_store;
+
+void entity_store_destroy(entity_store*);
+
+// append e, sets e->slot
+void entity_store_push(entity_store*, entity*);
+
+// leaves a hole at e->slot until the next entity_store_compact
+void entity_store_remove(entity_store*, entity*);
+
+// close holes left by entity_store_remove and bucket everything by type and
+// then awake/asleep, keeps spawn order within each bucket and fixes up slots
+void entity_store_compact(entity_store*);
+
+// copy all hot fields of e into its slot
+ALWAYS_INLINE void entity_store_sync(entity_store *s, const entity *e) {
+    const int i = e->slot;
+    s->type[i] = e->type;
+    s->index[i] = e->id.index;
+    s->pos[i] = e->pos;
+    s->px[i] = e->px;
+    s->tile[i] = e->tile;
+    s->health[i] = e->health;
+    s->asleep[i] = e->asleep;
+}
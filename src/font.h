@@ -8,6 +8,30 @@ enum {
     FONT_DOUBLED  = 1 << 0,
 };
 
+#ifdef HEADLESS
+// headless builds (see src/sim.c) draw nothing
+ALWAYS_INLINE void font_char(
+    ivec2s pos,
+    f32 z,
+    vec4s col,
+    int flags,
+    char c) {}
+
+ALWAYS_INLINE void font_str(
+    ivec2s pos,
+    f32 z,
+    vec4s col,
+    int flags,
+    const char *str) {}
+
+ALWAYS_INLINE void font_v(
+    ivec2s pos,
+    f32 z,
+    vec4s col,
+    int flags,
+    const char *fmt,
+    ...) {}
+#else
 void font_char(
     ivec2s pos,
     f32 z,
@@ -29,6 +53,7 @@ void font_v(
     int flags,
     const char *fmt,
     ...);
+#endif // ifdef HEADLESS
 
 int font_width(const char *str);
 
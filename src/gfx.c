@@ -484,4 +484,34 @@ void gfx_batcher_draw(
 
 void gfx_batcher_clear(gfx_batcher *batcher) {
     /* map_clear(&batcher->image_lists); */
+
+    // entries are normally freed by gfx_batcher_draw, but drop anything left
+    // over if the draw was skipped
+    map_each(u32, gfx_batcher_list*, &batcher->image_lists, it) {
+        dynlist_free(it.value->entries);
+    }
+}
+
+u64 gfx_batcher_hash(const gfx_batcher *batcher) {
+    // FNV-1a over image ids and entries (all 4 byte fields, no padding)
+    u64 h = 0xcbf29ce484222325ull;
+
+#define HASH_BYTES(_p, _n) do {                                              \
+        const u8 *_b = (const u8*) (_p);                                     \
+        for (usize _i = 0; _i < (_n); _i++) {                                \
+            h = (h ^ _b[_i]) * 0x100000001b3ull;                             \
+        }                                                                    \
+    } while (0)
+
+    map_each(u32, gfx_batcher_list*, &batcher->image_lists, it) {
+        const gfx_batcher_list *list = it.value;
+        if (dynlist_size(list->entries) == 0) { continue; }
+
+        HASH_BYTES(&list->image.id, sizeof(list->image.id));
+        HASH_BYTES(list->entries, dynlist_size_bytes(list->entries));
+    }
+
+#undef HASH_BYTES
+
+    return h;
 }
@@ -53,6 +53,31 @@ void gfx_atlas_destroy(gfx_atlas *atlas);
 void gfx_batcher_init(gfx_batcher *batcher);
 void gfx_batcher_destroy(gfx_batcher *batcher);
 
+#ifdef HEADLESS
+// headless builds (see src/sim.c) have no GL context, pushes are no-ops
+ALWAYS_INLINE void gfx_batcher_push_sprite(
+    gfx_batcher *batcher,
+    const gfx_atlas *atlas,
+    const gfx_sprite *sprite) {}
+
+ALWAYS_INLINE void gfx_batcher_push_image(
+    gfx_batcher *batcher,
+    sg_image image,
+    vec2s pos,
+    vec4s color,
+    f32 z,
+    int flags) {}
+
+ALWAYS_INLINE void gfx_batcher_push_subimage(
+    gfx_batcher *batcher,
+    sg_image image,
+    vec2s pos,
+    vec4s color,
+    f32 z,
+    int flags,
+    ivec2s offset,
+    ivec2s size) {}
+#else
 // push sprite to render from atlas
 void gfx_batcher_push_sprite(
     gfx_batcher *batcher,
@@ -76,6 +101,7 @@ void gfx_batcher_push_subimage(
     int flags,
     ivec2s offset,
     ivec2s size);
+#endif // ifdef HEADLESS
 
 void gfx_batcher_draw(
     const gfx_batcher *batcher,
@@ -83,3 +109,6 @@ void gfx_batcher_draw(
     const mat4s *view);
 
 void gfx_batcher_clear(gfx_batcher *batcher);
+
+// hash of everything currently queued, used to detect unchanged frames
+u64 gfx_batcher_hash(const gfx_batcher *batcher);
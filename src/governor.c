@@ -0,0 +1,48 @@
+#include "governor.h"
+
+#include <cjam/log.h>
+#include <cjam/math.h>
+
+static const char *GOV_NAMES[GOV_COUNT] = {
+    [GOV_NONE]                 = "nothing",
+    [GOV_SHED_BURSTS]          = "particle bursts",
+    [GOV_SHED_MUSIC_PARTICLES] = "music particles",
+    [GOV_SHED_RADAR]           = "radar overlays",
+    [GOV_SHED_MUSIC_UPDATE]    = "music updates",
+};
+
+static void set_level(governor *g, int level) {
+    if (level > g->level) {
+        WARN(
+            "governor: over budget (load %.2f of %.2fms), shedding %s",
+            g->load, g->budget_ns / 1000000.0f, GOV_NAMES[level]);
+    } else {
+        LOG(
+            "governor: load %.2f, restoring %s",
+            g->load, GOV_NAMES[g->level]);
+    }
+
+    g->level = level;
+    g->since_change = 0;
+    g->calm_frames = 0;
+}
+
+void governor_update(governor *g, u64 budget_ns, u64 work_ns, bool capped) {
+    g->budget_ns = max(budget_ns, 1);
+
+    // react to spikes quickly, recover slowly
+    const f32 load = work_ns / (f32) g->budget_ns;
+    g->load = lerp(g->load, load, load > g->load ? 0.25f : 0.05f);
+
+    g->since_change++;
+    g->calm_frames = g->load < GOV_LOAD_LOW ? g->calm_frames + 1 : 0;
+
+    if ((capped || g->load > GOV_LOAD_HIGH)
+        && g->level < GOV_COUNT - 1
+        && g->since_change >= GOV_RAISE_FRAMES) {
+        set_level(g, g->level + 1);
+    } else if (g->level > GOV_NONE
+        && g->calm_frames >= GOV_LOWER_FRAMES) {
+        set_level(g, g->level - 1);
+    }
+}
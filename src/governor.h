@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cjam/types.h>
+#include <cjam/macros.h>
+
+// overload governor: when frames run over budget, cosmetic work is shed in
+// order of increasing level until the simulation can keep up again
+enum {
+    GOV_NONE = 0,
+
+    // particle_new_multi_splat/_smoke bursts are cut down
+    GOV_SHED_BURSTS,
+
+    // no boombox music particles
+    GOV_SHED_MUSIC_PARTICLES,
+
+    // no radar range/spawn overlays
+    GOV_SHED_RADAR,
+
+    // level_update_music only runs every GOV_MUSIC_INTERVAL ticks
+    GOV_SHED_MUSIC_UPDATE,
+
+    GOV_COUNT
+};
+
+#define GOV_MUSIC_INTERVAL 10
+
+// frames between level changes
+#define GOV_RAISE_FRAMES 15
+#define GOV_LOWER_FRAMES 120
+
+// load (work / budget) thresholds
+#define GOV_LOAD_HIGH 0.9f
+#define GOV_LOAD_LOW 0.6f
+
+typedef struct {
+    int level;
+
+    // smoothed frame work / budget
+    f32 load;
+
+    // current per-frame budget
+    u64 budget_ns;
+
+    // frames since level last changed, frames spent under GOV_LOAD_LOW
+    int since_change, calm_frames;
+} governor;
+
+// work_ns is the time spent on the last frame excluding frame limiting and
+// swap.
+// capped is true if the frame had to drop ticks to stay under its tick cap.
+void governor_update(governor*, u64 budget_ns, u64 work_ns, bool capped);
+
+ALWAYS_INLINE bool governor_shed(const governor *g, int level) {
+    return g->level >= level;
+}
@@ -9,6 +9,8 @@
 #include <cjam/rand.h>
 #include <cjam/map.h>
 
+#include <limits.h>
+
 static const char char_to_tile[256] = {
     ['?'] = TILE_NONE,
     [' '] = TILE_BASE,
@@ -36,9 +38,7 @@ static const int char_to_flags[256] = {
 void level_init(level *level, const level_data *data) {
     memset(level->tiles, 0, sizeof(level->tiles));
     level->data = data;
-
-    // TODO: free
-    level->entities = calloc(1, MAX_ENTITIES * sizeof(entity));
+    timer_wheel_init(&level->timers, state->time.tick);
 
     for (int x = 0; x < LEVEL_WIDTH; x++) {
         for (int y = 0; y < LEVEL_HEIGHT; y++) {
@@ -56,6 +56,7 @@ void level_init(level *level, const level_data *data) {
             entity_type etype = char_to_entity[(int) c];
             if (etype != ENTITY_TYPE_NONE) {
                 entity *e = level_new_entity(level, etype);
+                if (!e) { continue; }
                 entity_set_pos(
                     e,
                     IVEC2S2V(level_tile_to_px((ivec2s) {{ x, y }})));
@@ -66,13 +67,26 @@ void level_init(level *level, const level_data *data) {
 
  void level_destroy(level *level){
      /// /hasfiuasfjkasghfajksgf
-    dlist_each(node, &level->all_entities, it) {
-        if (it.el->path) {
-            dynlist_free(it.el->path);
+    for (int i = 0; i < level->hot.size; i++) {
+        entity *e = level->hot.entity[i];
+        if (e && e->path) {
+            dynlist_free(e->path);
         }
     }
 
-    free(level->entities);
+    entity_store_destroy(&level->hot);
+
+    for (int i = 0; i < level->num_entity_chunks; i++) {
+        free(level->entity_chunks[i]);
+    }
+
+    dynlist_free(level->free_entities);
+    dynlist_free(level->commands);
+    timer_wheel_destroy(&level->timers);
+    dynlist_free(level->due_timers);
+    dynlist_free(level->grid_entities);
+    dynlist_free(level->enemy_entities);
+    dynlist_free(level->enemy_boxes);
  }
 
 bool level_find_near_tile(level *l, ivec2s lpos, tile_type type, ivec2s *out) {
@@ -102,13 +116,15 @@ static void spawn_random_ship(level *level) {
     struct rand r = rand_create(state->time.tick);
     for (int x = 0; x < LEVEL_WIDTH; x++) {
         for (int y = 0; y < LEVEL_HEIGHT; y++) {
+            const ivec2s p = IVEC2S(x, y);
             if ((level->flags[x][y] & LTF_ALIEN_SPAWN)
-                && level->tile_entities[x][y].head == NULL) {
-                const ivec2s p = IVEC2S(x, y);
+                && !level_tile_has_entities(level, p)) {
                 const entity_type type =
                     level->data->ships[rand_n(&r, 0, nships - 1)].type;
                 entity *ship = level_new_entity(level, type);
-                entity_set_pos(ship, IVEC2S2V(level_tile_to_px(p)));
+                if (ship) {
+                    entity_set_pos(ship, IVEC2S2V(level_tile_to_px(p)));
+                }
                 return;
             }
         }
@@ -125,8 +141,9 @@ void level_go(level *level) {
             &start_road));
 
     entity *truck = level_new_entity(level, ENTITY_TRUCK);
+    ASSERT(truck);
     entity_set_pos(truck, IVEC2S2V(level_tile_to_px(start_road)));
-    truck->health = state->stats.truck_health;
+    entity_set_health(truck, state->stats.truck_health);
 
     // spawn ships
     DYNLIST(ivec2s) ship_locations = NULL;
@@ -155,10 +172,8 @@ retry:;
             const ivec2s p = dynlist_remove(ship_locations, k);
 
             // check for entities
-            entity *entities[64];
-            const int n = level_get_tile_entities(level, p, entities, 64);
-            for (int k = 0; k < n; k++) {
-                if (!(E_INFO(entities[k])->flags & EIF_CAN_SPAWN)) {
+            level_tile_each(level, p, it) {
+                if (!(E_FLAGS(it.el) & EIF_CAN_SPAWN)) {
                     LOG("can't spawn on %d, %d", p.x, p.y);
                     goto retry;
                 }
@@ -166,6 +181,7 @@ retry:;
 
             LOG("spawning!!, %d %d", p.x, p.y);
             entity *ship = level_new_entity(level, type);
+            if (!ship) { goto done; }
             entity_set_pos(ship, IVEC2S2V(level_tile_to_px(p)));
         }
     }
@@ -174,24 +190,102 @@ done:
     dynlist_free(ship_locations);
 }
 
+void level_push_command(level *level, level_command c) {
+    *dynlist_push(level->commands) = c;
+}
+
+static void apply_command(level *level, const level_command *c) {
+    switch (c->type) {
+    case LEVEL_COMMAND_SPAWN: {
+        entity *e = level_new_entity(level, c->spawn.type);
+        if (!e) { break; }
+
+        e->bullet.velocity = c->spawn.velocity;
+        e->bullet.target = c->spawn.target;
+        e->bullet.has_target = c->spawn.has_target;
+        entity_set_pos(e, c->spawn.pos);
+    } break;
+    case LEVEL_COMMAND_DAMAGE: {
+        // target may have been deleted this tick
+        entity *e = level_get_entity(level, c->damage.target);
+        if (e) {
+            entity_set_health(e, e->health - c->damage.amount);
+            level_wake_entity(level, e);
+        }
+    } break;
+    case LEVEL_COMMAND_MONEY:
+        state->stats.money += c->money;
+        break;
+    case LEVEL_COMMAND_STAGE:
+        state_set_stage(state, c->stage);
+        break;
+    case LEVEL_COMMAND_TRUCK_HEALTH:
+        state->stats.truck_health = c->truck_health;
+        break;
+    }
+}
+
 void level_tick(level *level) {
     DYNLIST(entity*) delete_entities = NULL;
 
-    dlist_each(node, &level->all_entities, it) {
-        if (it.el->delete) { goto deleted; }
+    trace *tr = &state->trace;
+    if (tr->enabled) { trace_tick_begin(tr); }
+
+    // one grid for the whole tick, see level::grid_dirty
+    if (level->grid_dirty) { level_build_grid(level); }
+    level->grid_frozen = true;
+
+    // due timers first, they can wake entities to tick this tick
+    timer_wheel_advance(&level->timers, state->time.tick, &level->due_timers);
+    dynlist_each(level->due_timers, it) {
+        entity *e = level_get_entity(level, it.el->entity);
+        if (!e) { continue; }
+
+        e->timers &= ~(1 << it.el->action);
+        entity_timer_fire(e, it.el->action, it.el->arg);
+    }
+    dynlist_resize(level->due_timers, 0);
+
+    // sort in entities spawned or woken between ticks (level_go, ui,
+    // spawn_random_ship, stage changes)
+    entity_store *hot = &level->hot;
+    entity_store_compact(hot);
+
+    // the awake part of each type's span, asleep entities are skipped
+    // entirely until woken
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++) {
+        const int start = hot->type_start[t], end = hot->type_awake[t];
+        for (int i = start; i < end; i++) {
+            hot->entity[i]->prev_pos = hot->pos[i];
+        }
+
+        if (start == end) { continue; }
 
-        f_entity_tick f_tick = ENTITY_INFO[it.el->type].tick;
-        if (f_tick) { f_tick(it.el); }
-        it.el->ticks_alive++;
+        const u64 t_start = tr->enabled ? time_ns() : 0;
+        entity_tick_span(hot, t, start, end);
 
-        if (!level_px_in_bounds(it.el->px)
-            || !level_tile_in_bounds(it.el->tile)) {
-            it.el->delete = true;
+        if (tr->enabled) {
+            trace_tick_entities(tr, t, end - start, time_ns() - t_start);
         }
+    }
+
+    // asleep entities don't move, and are woken before being deleted
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++) {
+        for (int i = hot->type_start[t]; i < hot->type_awake[t]; i++) {
+            entity *e = hot->entity[i];
+
+            if (!e->delete) {
+                e->ticks_alive++;
+
+                if (!level_px_in_bounds(hot->px[i])
+                    || !level_tile_in_bounds(hot->tile[i])) {
+                    e->delete = true;
+                }
+            }
 
-deleted:
-        if (it.el->delete) {
-            *dynlist_push(delete_entities) = it.el;
+            if (e->delete) {
+                *dynlist_push(delete_entities) = e;
+            }
         }
     }
 
@@ -199,10 +293,25 @@ deleted:
         level_delete_entity(level, *it.el);
     }
 
+    // merge phase, after deletes so damage to deleted entities is dropped.
+    // spawned entities first tick next tick.
+    for (int i = 0; i < (int) dynlist_size(level->commands); i++) {
+        apply_command(level, &level->commands[i]);
+    }
+    dynlist_resize(level->commands, 0);
+    level->grid_frozen = false;
+
+    entity_store_compact(hot);
+
     dynlist_free(delete_entities);
 
+    if (tr->enabled) { trace_tick_end(tr); }
+
     // TODO: very inefficient
-    level_update_music(level);
+    if (!governor_shed(&state->gov, GOV_SHED_MUSIC_UPDATE)
+        || state->time.tick % GOV_MUSIC_INTERVAL == 0) {
+        level_update_music(level);
+    }
 
     if (state->stage == STAGE_PLAY) {
         struct rand r = rand_create(state->time.tick);
@@ -219,12 +328,13 @@ deleted:
 
 void level_update_music(level *l) {
     memset(&l->music_level, 0, sizeof(l->music_level));
-    dlist_each(node, &l->all_entities, it) {
-        if (it.el->type != ENTITY_BOOMBOX) { continue; }
+    for (int i = 0; i < l->hot.size; i++) {
+        if (l->hot.type[i] != ENTITY_BOOMBOX) { continue; }
 
+        const ivec2s tile = l->hot.tile[i];
         for (int x = -2; x <= 2; x++) {
             for (int y = -2; y <= 2; y++) {
-                const ivec2s pos = {{ it.el->tile.x + x, it.el->tile.y + y }};
+                const ivec2s pos = {{ tile.x + x, tile.y + y }};
                 if (!level_tile_in_bounds(pos)) { continue; }
                 l->music_level[pos.x][pos.y]++;
             }
@@ -232,13 +342,6 @@ void level_update_music(level *l) {
     }
 }
 
-void level_update(level *level, f32 dt) {
-    dlist_each(node, &level->all_entities, it) {
-        f_entity_update f_update = ENTITY_INFO[it.el->type].update;
-        if (f_update) { f_update(it.el, dt); }
-    }
-}
-
 static void get_surround(
     const level *level,
     ivec2s lpos,
@@ -290,7 +393,7 @@ static void tile_draw(
                 &state->atlas.tile,
                 &(gfx_sprite) {
                     .pos = {{ lpos.x * TILE_SIZE_PX, lpos.y * TILE_SIZE_PX }},
-                    .index = {{ 8 + (state->time.animtick % 2), 4 + rand_n(&rng, 0, 2) }},
+                    .index = {{ 8 + (state->render->animtick % 2), 4 + rand_n(&rng, 0, 2) }},
                     .color = COLOR_WHITE,
                     .z = z - 0.0001f,
                     .flags = GFX_NO_FLAGS
@@ -316,7 +419,7 @@ static void tile_draw(
     } break;
     case TILE_LAKE: {
         tile_draw(level, lpos, TILE_BASE);
-        index = IVEC2S(9, 1 + state->time.animtick % 3);
+        index = IVEC2S(9, 1 + state->render->animtick % 3);
         z -= 0.001f;
     } break;
     case TILE_STONE: {
@@ -397,167 +500,462 @@ static void tile_draw(
         });
 }
 
-void level_draw(const level *level) {
+void level_draw(const level *level, const render_snapshot *snap) {
     for (int x = 0; x < LEVEL_WIDTH; x++) {
         for (int y = 0; y < LEVEL_HEIGHT; y++) {
             tile_draw(level, (ivec2s) {{ x, y }}, level->tiles[x][y]);
         }
     }
 
-    dlist_each(node, &level->all_entities, it) {
-        f_entity_draw f_draw = ENTITY_INFO[it.el->type].draw;
-        if (f_draw) { f_draw(it.el); }
+    dynlist_each(snap->entities, it) {
+        entity_draw(it.el);
+    }
+}
+
+// allocate another chunk of entities and put its indices on the free stack
+static bool grow_entities(level *level) {
+    if (level->num_entity_chunks == MAX_ENTITY_CHUNKS) {
+        return false;
+    }
+
+    const int c = level->num_entity_chunks++;
+    level->entity_chunks[c] = calloc(1, ENTITY_CHUNK_SIZE * sizeof(entity));
+
+    // lowest indices on top so they are handed out first
+    for (int i = ENTITY_CHUNK_SIZE - 1; i >= 0; i--) {
+        *dynlist_push(level->free_entities) = (c * ENTITY_CHUNK_SIZE) + i;
+    }
+
+    return true;
+}
+
+// add (d = +1) or remove (d = -1) e from type lists and counts
+static void count_entity(level *level, entity *e, int d) {
+    if (d > 0) {
+        dlist_append(type_node, &level->type_entities[e->type], e);
+    } else {
+        dlist_remove(type_node, &level->type_entities[e->type], e);
+    }
+
+    level->num_type_entities[e->type] += d;
+
+    const int flags = E_FLAGS(e);
+    for (int i = 0; i < EIF_NUM_FLAGS; i++) {
+        if (flags & (1 << i)) { level->num_flag_entities[i] += d; }
     }
 }
 
 entity *level_new_entity(level *level, entity_type type) {
-    int n = 0, i = level->last_free_entity;
-    while (n < MAX_ENTITIES) {
-        if (!level->entities[i].id.present) {
-            break;
+    if (dynlist_size(level->free_entities) == 0 && !grow_entities(level)) {
+        // only warn once per level, this gets hit every tick when it happens
+        if (level->failed_entities++ == 0) {
+            WARN("out of entities (%d), can't spawn %d", MAX_ENTITIES, type);
         }
-
-        i = (i + 1) % MAX_ENTITIES;
+        return NULL;
     }
 
-    level->last_free_entity = i;
-    entity *e = &level->entities[i];
+    const int i = dynlist_pop(level->free_entities);
+    entity *e = level_entity_at(level, i);
+    ASSERT(!e->id.present);
     const u16 old_gen = e->id.gen;
     memset(e, 0, sizeof(*e));
     const entity_info *info = &ENTITY_INFO[type];
     memcpy(e, &info->base, sizeof(*e));
     e->type = type;
+    e->enemy_box = -1;
     e->id = (entity_id) {
         .present = true,
         .gen = old_gen + 1,
         .index = i
     };
-    dlist_append(node, &level->all_entities, e);
+    entity_store_push(&level->hot, e);
+    count_entity(level, e, +1);
+    level->num_entities++;
+    level->peak_entities = max(level->peak_entities, level->num_entities);
     return e;
 }
 
 void level_delete_entity(level *level, entity *e) {
-    dlist_remove(node, &level->all_entities, e);
+    level_wake_entity(level, e);
+    entity_store_remove(&level->hot, e);
+    count_entity(level, e, -1);
 
-    if (e->on_tile) {
-        dlist_remove(
-            tile_node,
-            &state->level->tile_entities[e->tile.x][e->tile.y],
-            e);
+    if (e->on_tile && (E_FLAGS(e) & EIF_ENEMY)) {
+        const ivec2s r = level_tile_region(e->tile);
+        level->region_enemies[r.x][r.y]--;
     }
 
+    level->grid_dirty = true;
+
     if (e->path) {
         dynlist_free(e->path);
     }
 
     e->id.present = false;
+    *dynlist_push(level->free_entities) = e->id.index;
+    level->num_entities--;
 }
 
-entity *level_get_entity(level *level, entity_id id) {
-    if (!memcmp(
-            &level->entities[id.index].id,
-            &id,
-            sizeof(id))) {
-        return &level->entities[id.index];
+void level_sleep_entity(level *level, entity *e, level_wake wake) {
+    if (e->asleep) { return; }
+
+    int list = wake;
+    if (wake == LEVEL_WAKE_REGION) {
+        const ivec2s r = level_tile_region(e->tile);
+        list += (r.x * LEVEL_REGIONS_Y) + r.y;
     }
 
-    return NULL;
+    e->asleep = true;
+    e->sleep_list = list;
+    e->sleep_tick = state->time.tick;
+    dlist_append(sleep_node, &level->sleepers[list], e);
+    level->num_asleep++;
+
+    // moved out of its type's awake span by the next compact
+    level->hot.asleep[e->slot] = true;
+    level->hot.dirty = true;
 }
 
-entity *level_find_entity(level *l, entity_type type) {
-    dlist_each(node, &l->all_entities, it) {
-        if (it.el->type == type) {
-            return it.el;
-        }
+void level_wake_entity(level *level, entity *e) {
+    if (!e->asleep) { return; }
+
+    e->asleep = false;
+    dlist_remove(sleep_node, &level->sleepers[e->sleep_list], e);
+    level->num_asleep--;
+
+    level->hot.asleep[e->slot] = false;
+    level->hot.dirty = true;
+}
+
+static void wake_list(level *level, int list) {
+    while (level->sleepers[list].head) {
+        level_wake_entity(level, level->sleepers[list].head);
     }
+}
 
-    return NULL;
+void level_wake_all(level *level) {
+    for (int i = 0; i < LEVEL_SLEEP_LISTS; i++) {
+        wake_list(level, i);
+    }
 }
 
-int level_get_tile_entities(level *l, ivec2s tile, entity **es, int n) {
-    int i = 0;
-    dlist_each(tile_node, &l->tile_entities[tile.x][tile.y], it) {
-        if (i >= n) {
-            WARN("no more space for entities");
-            return n;
-        }
+void level_move_enemy(level *level, entity *e, bool was_on_tile, ivec2s from) {
+    if (was_on_tile) {
+        const ivec2s r = level_tile_region(from);
+        level->region_enemies[r.x][r.y]--;
+    }
 
-        es[i++] = it.el;
+    if (e->on_tile) {
+        const ivec2s r = level_tile_region(e->tile);
+        level->region_enemies[r.x][r.y]++;
+        wake_list(level, LEVEL_WAKE_REGION + (r.x * LEVEL_REGIONS_Y) + r.y);
     }
-    return i;
 }
 
-int level_get_box_entities(level *l, const aabb *box, entity **es, int n) {
+void level_schedule(
+    level *level, entity *e, entity_timer action, int arg, u64 tick) {
+    timer_wheel_add(
+        &level->timers,
+        (timer) {
+            .tick = tick,
+            .entity = e->id,
+            .action = action,
+            .arg = arg
+        });
+    e->timers |= 1 << action;
+}
+
+entity *level_get_entity(level *level, entity_id id) {
+    if (!id.present
+        || id.index >= level->num_entity_chunks * ENTITY_CHUNK_SIZE) {
+        return NULL;
+    }
+
+    entity *e = level_entity_at(level, id.index);
+    return !memcmp(&e->id, &id, sizeof(id)) ? e : NULL;
+}
+
+entity *level_find_entity(level *l, entity_type type) {
+    return l->type_entities[type].head;
+}
+
+// point it at the entities on it->tile
+static void iter_cell(level_iter *it) {
+    const level *l = it->l;
+    const int t = (it->tile.x * LEVEL_HEIGHT) + it->tile.y;
+
+    it->i = 0;
+    if (it->boxes) {
+        it->n = l->enemy_start[t + 1] - l->enemy_start[t];
+        it->cell = l->enemy_entities + l->enemy_start[t];
+        it->boxes = l->enemy_boxes + l->enemy_start[t];
+    } else {
+        it->cell = level_grid_cell(l, it->tile, &it->n);
+    }
+}
+
+level_iter level_box_iter(level *l, const aabb *box, bool enemies) {
+    level_update_grid(l);
+
+    // entities are on the tile of their position, so can stick out one tile
+    // past it
     const ivec2s
         tmin = level_clamp_tile(glms_ivec2_add(level_px_to_tile(box->min), IVEC2S(-1))),
         tmax = level_clamp_tile(glms_ivec2_add(level_px_to_tile(box->max), IVEC2S(+1)));
 
-    int i = 0;
-    for (int x = tmin.x; x <= tmax.x; x++) {
-        for (int y = tmin.y; y <= tmax.y; y++) {
-            dlist_each(tile_node, &state->level->tile_entities[x][y], it) {
-                const aabb b = entity_aabb(it.el);
-                if (aabb_collides(*box, b)) {
-                    es[i++] = it.el;
-                    if (i == n) {
-                        WARN("ran out of space for entities");
-                        return n;
-                    }
+    level_iter it = {
+        .l = l,
+        .tile = tmin,
+        .tmin = tmin,
+        .tmax = tmax,
+        .box = *box,
+        .boxes = enemies ? l->enemy_boxes : NULL,
+    };
+    iter_cell(&it);
+    return it;
+}
+
+bool level_box_iter_next(level_iter *it) {
+    while (true) {
+        while (it->i < it->n) {
+            const int i = it->i++;
+
+            // enemies are tested without looking at the entity
+            if (it->boxes) {
+                if (aabb_collides(it->box, it->boxes[i])) {
+                    it->el = level_entity_at(it->l, it->cell[i]);
+                    return true;
                 }
+                continue;
+            }
+
+            entity *e = level_entity_at(it->l, it->cell[i]);
+            if (aabb_collides(it->box, entity_aabb(e))) {
+                it->el = e;
+                return true;
             }
         }
+
+        // next tile, column by column
+        if (++it->tile.y > it->tmax.y) {
+            it->tile.y = it->tmin.y;
+            if (++it->tile.x > it->tmax.x) { return false; }
+        }
+
+        iter_cell(it);
+    }
+}
+
+// search tile x, y for level_query_nearest, keeping es/scores sorted best
+// first. returns true once the k results can't be beaten by anything
+// scoring at most bound.
+static bool query_tile(
+    level *l, int x, int y, const level_query *q,
+    entity **es, int *scores, int *n, int k, int bound) {
+    const int t = (x * LEVEL_HEIGHT) + y;
+    if (q->flags && !(l->grid_flags[t] & q->flags)) { return false; }
+
+    for (int i = l->grid_start[t]; i < l->grid_start[t + 1]; i++) {
+        entity *e = level_entity_at(l, l->grid_entities[i]);
+        if (q->flags && !(E_FLAGS(e) & q->flags)) { continue; }
+
+        const int p = q->priority(e, q->userdata);
+        if (p <= 0 || (*n == k && p <= scores[k - 1])) { continue; }
+
+        // insert after everything at least as good, dropping the worst if
+        // full
+        int j = min(*n, k - 1);
+        for (; j > 0 && scores[j - 1] < p; j--) {
+            es[j] = es[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        es[j] = e;
+        scores[j] = p;
+        *n = min(*n + 1, k);
     }
 
-    return i;
+    return *n == k && scores[k - 1] >= bound;
 }
 
-entity *level_find_nearest_entity(level *l, ivec2s pos, f_entity_priority f_pri, void *userdata) {
-    int pri = 0;
-    entity *res = NULL;
+int level_query_nearest(
+    level *l, ivec2s pos, const level_query *q, entity **es, int k) {
+    ASSERT(k > 0 && k <= LEVEL_QUERY_MAX_K);
+    int scores[LEVEL_QUERY_MAX_K], n = 0;
+
+    level_update_grid(l);
+    pos = level_clamp_tile(pos);
+
+    // rings past the farthest edge are off the level
+    const int last =
+        max(max(pos.x, LEVEL_WIDTH - 1 - pos.x),
+            max(pos.y, LEVEL_HEIGHT - 1 - pos.y));
+    const int radius = q->radius < 0 ? last : min(q->radius, last);
+
+    for (int r = 0; r <= radius; r++) {
+        const int bound = q->bound ? q->bound(r, q->userdata) : INT_MAX;
+        if (n == k && scores[k - 1] >= bound) { break; }
+
+        // rows above and below, then the columns between them, skipping
+        // anything off the level
+        const int
+            x0 = max(pos.x - r, 0),
+            x1 = min(pos.x + r, LEVEL_WIDTH - 1),
+            y0 = max(pos.y - r + 1, 0),
+            y1 = min(pos.y + r - 1, LEVEL_HEIGHT - 1);
+
+        const int rows[2] = { pos.y - r, pos.y + r };
+        for (int i = 0; i < (r ? 2 : 1); i++) {
+            if (rows[i] < 0 || rows[i] >= LEVEL_HEIGHT) { continue; }
+            for (int x = x0; x <= x1; x++) {
+                if (query_tile(l, x, rows[i], q, es, scores, &n, k, bound)) {
+                    return n;
+                }
+            }
+        }
 
-    ivec2s offset = {{ 0, 0 }};
-    int i = 0, leg = 0, layer = 0;
-    while (i < 1024) {
-        dlist_each(tile_node, &l->tile_entities[pos.x][pos.y], it) {
-            int p = f_pri(it.el, userdata);
-            if (p > pri) {
-                pri = p;
-                res = it.el;
+        const int cols[2] = { pos.x - r, pos.x + r };
+        for (int i = 0; i < (r ? 2 : 0); i++) {
+            if (cols[i] < 0 || cols[i] >= LEVEL_WIDTH) { continue; }
+            for (int y = y0; y <= y1; y++) {
+                if (query_tile(l, cols[i], y, q, es, scores, &n, k, bound)) {
+                    return n;
+                }
             }
         }
+    }
 
-        switch (leg) {
-        case 0:
-            pos.y++;
-            offset.y++;
-            if (+offset.y == layer || pos.y >= LEVEL_HEIGHT) { leg++; }
-            break;
-        case 1:
-            pos.x++; offset.x++;
-            if (+offset.x == layer || pos.x >= LEVEL_WIDTH) { leg++; }
-            break;
-        case 2:
-            pos.y--; offset.y--;
-            if (-offset.y == layer || pos.y < 0) { leg++; }
-            break;
-        case 3:
-            pos.x--; offset.x--;
-            if (-offset.x == layer || pos.x < 0) { leg = 0; layer++; }
-            break;
+    return n;
+}
+
+bool level_tile_has_entities(level *l, ivec2s pos) {
+    int n;
+    level_tile_grid(l, pos, &n);
+    return n != 0;
+}
+
+// fill level::turret_targets by searching out from every enemy of the best
+// rank there is, first come first served. steps are to all 8 neighbours so
+// tiles get whatever is fewest rings away, as with level_query_nearest.
+static void build_turret_targets(level *l) {
+    int queue[LEVEL_WIDTH * LEVEL_HEIGHT];
+    bool seen[LEVEL_WIDTH * LEVEL_HEIGHT];
+
+    // ground enemies before ships
+    for (int ships = 0; ships < 2; ships++) {
+        memset(seen, 0, sizeof(seen));
+        int head = 0, tail = 0;
+
+        for (int t = 0; t < (LEVEL_WIDTH * LEVEL_HEIGHT); t++) {
+            if (!(l->grid_flags[t] & EIF_ENEMY)) { continue; }
+
+            for (int i = l->grid_start[t]; i < l->grid_start[t + 1]; i++) {
+                const entity *e = level_entity_at(l, l->grid_entities[i]);
+                const int flags = E_FLAGS(e);
+                if ((flags & EIF_ENEMY) && !!(flags & EIF_SHIP) == ships) {
+                    l->turret_targets[t] = e->id;
+                    seen[t] = true;
+                    queue[tail++] = t;
+                    break;
+                }
+            }
         }
 
-        pos = (ivec2s) {{
-            clamp(pos.x, 0, LEVEL_WIDTH - 1),
-            clamp(pos.y, 0, LEVEL_HEIGHT - 1),
-        }};
-        i++;
+        if (tail == 0) { continue; }
+
+        while (head < tail) {
+            const int t = queue[head++];
+            const int x = t / LEVEL_HEIGHT, y = t % LEVEL_HEIGHT;
+
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    const ivec2s n = IVEC2S(x + dx, y + dy);
+                    if (!level_tile_in_bounds(n)) { continue; }
+
+                    const int u = (n.x * LEVEL_HEIGHT) + n.y;
+                    if (seen[u]) { continue; }
+
+                    l->turret_targets[u] = l->turret_targets[t];
+                    seen[u] = true;
+                    queue[tail++] = u;
+                }
+            }
+        }
+
+        return;
     }
 
-    return res;
+    for (int t = 0; t < (LEVEL_WIDTH * LEVEL_HEIGHT); t++) {
+        l->turret_targets[t] = ENTITY_NONE;
+    }
 }
 
-bool level_tile_has_entities(level *l, ivec2s pos) {
-    return l->tile_entities[pos.x][pos.y].head != NULL;
+entity_id level_turret_target(level *l, ivec2s tile) {
+    if (l->turret_targets_tick != state->time.tick) {
+        level_update_grid(l);
+        build_turret_targets(l);
+        l->turret_targets_tick = state->time.tick;
+    }
+
+    tile = level_clamp_tile(tile);
+    return l->turret_targets[(tile.x * LEVEL_HEIGHT) + tile.y];
+}
+
+void level_build_grid(level *l) {
+    const entity_store *hot = &l->hot;
+    int next[LEVEL_WIDTH * LEVEL_HEIGHT] = { 0 },
+        enext[LEVEL_WIDTH * LEVEL_HEIGHT] = { 0 };
+
+    // count per tile, holes left by deletes have type ENTITY_TYPE_NONE
+    int n = 0, m = 0;
+    for (int i = 0; i < hot->size; i++) {
+        if (hot->type[i] == ENTITY_TYPE_NONE) { continue; }
+        const int t = (hot->tile[i].x * LEVEL_HEIGHT) + hot->tile[i].y;
+        next[t]++;
+        n++;
+
+        if (entity_type_flags(hot->type[i]) & EIF_ENEMY) {
+            enext[t]++;
+            m++;
+        }
+    }
+
+    memset(l->grid_flags, 0, sizeof(l->grid_flags));
+
+    int start = 0, estart = 0;
+    for (int t = 0; t < (LEVEL_WIDTH * LEVEL_HEIGHT); t++) {
+        l->grid_start[t] = start;
+        start += next[t];
+        next[t] = l->grid_start[t];
+
+        l->enemy_start[t] = estart;
+        estart += enext[t];
+        enext[t] = l->enemy_start[t];
+    }
+    l->grid_start[LEVEL_WIDTH * LEVEL_HEIGHT] = n;
+    l->enemy_start[LEVEL_WIDTH * LEVEL_HEIGHT] = m;
+
+    dynlist_resize(l->grid_entities, n);
+    dynlist_resize(l->enemy_entities, m);
+    dynlist_resize(l->enemy_boxes, m);
+    for (int i = 0; i < hot->size; i++) {
+        if (hot->type[i] == ENTITY_TYPE_NONE) { continue; }
+        const int t = (hot->tile[i].x * LEVEL_HEIGHT) + hot->tile[i].y;
+        const int flags = entity_type_flags(hot->type[i]);
+        l->grid_entities[next[t]++] = hot->index[i];
+        l->grid_flags[t] |= flags;
+
+        if (flags & EIF_ENEMY) {
+            // as entity_aabb
+            const int j = enext[t]++;
+            l->enemy_entities[j] = hot->index[i];
+            hot->entity[i]->enemy_box = j;
+            l->enemy_boxes[j] =
+                aabb_translate(
+                    ENTITY_HOT[hot->type[i]].aabb, VEC2S2I(hot->pos[i]));
+        }
+    }
+
+    l->grid_dirty = false;
 }
 
 static hash_type hash_ivec2s(ivec2s v) {
@@ -597,8 +995,7 @@ int level_path_default_weight(const level *l, ivec2s p, void*) {
     return 1;
 }
 
-// weight(...) returns < 0 if traversal is not possible
-bool level_path(
+static bool level_path_impl(
     level *level,
     DYNLIST(ivec2s) *dst,
     ivec2s start,
@@ -717,12 +1114,28 @@ bool level_path(
     return success;
 }
 
-bool level_has_enemies(level *l) {
-    dlist_each(node, &l->all_entities, it) {
-        if (E_INFO(it.el)->flags & (EIF_ENEMY | EIF_SHIP)) {
-            return true;
-        }
+// weight(...) returns < 0 if traversal is not possible
+bool level_path(
+    level *level,
+    DYNLIST(ivec2s) *dst,
+    ivec2s start,
+    ivec2s goal,
+    int (*weight)(const struct level_s*, ivec2s, void*),
+    void *userptr) {
+    if (!state->trace.enabled) {
+        return level_path_impl(level, dst, start, goal, weight, userptr);
     }
 
-    return false;
+    const u64 t_start = time_ns();
+    const bool success =
+        level_path_impl(level, dst, start, goal, weight, userptr);
+    trace_push(
+        &state->trace, "level_path", "path", trace_tid,
+        t_start, time_ns(), "length", success ? (i64) dynlist_size(*dst) : -1);
+    return success;
+}
+
+bool level_has_enemies(level *l) {
+    return level_num_flag_entities(l, EIF_ENEMY) > 0
+        || level_num_flag_entities(l, EIF_SHIP) > 0;
 }
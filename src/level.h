@@ -6,8 +6,10 @@
 
 #include "cjam/aabb.h"
 #include "defs.h"
+#include "entity_store.h"
+#include "timer_wheel.h"
 
-typedef struct entity_s entity;
+typedef struct render_snapshot_s render_snapshot;
 
 // TODO
 typedef struct {
@@ -20,6 +22,72 @@ typedef struct {
     int bonus;
 } level_data;
 
+// tiles are grouped into square regions so entities sleeping until an enemy
+// comes near can be woken without searching, see level_sleep_entity
+#define LEVEL_REGION_SIZE 4
+#define LEVEL_REGIONS_X                                                      \
+    ((LEVEL_WIDTH + LEVEL_REGION_SIZE - 1) / LEVEL_REGION_SIZE)
+#define LEVEL_REGIONS_Y                                                      \
+    ((LEVEL_HEIGHT + LEVEL_REGION_SIZE - 1) / LEVEL_REGION_SIZE)
+
+// what wakes a sleeping entity, on top of stage changes and damage which
+// wake it regardless
+typedef enum {
+    LEVEL_WAKE_DAMAGE = 0, // nothing else
+    LEVEL_WAKE_REGION,     // an enemy entering the entity's region
+} level_wake;
+
+// number of level::sleepers, LEVEL_WAKE_REGION + (x * LEVEL_REGIONS_Y) + y
+// for region x, y
+#define LEVEL_SLEEP_LISTS                                                    \
+    (LEVEL_WAKE_REGION + (LEVEL_REGIONS_X * LEVEL_REGIONS_Y))
+
+// world changes issued by entity ticks. they are queued in level::commands
+// and applied in issue order by level_tick once every entity has ticked.
+//
+// ticks still write shared state outside of commands, so they are not safe
+// to run in parallel:
+// - entity_set_pos marks the grid dirty and, for enemies, updates
+//   region_enemies and wakes sleepers (level_move_enemy)
+// - level_sleep_entity, level_wake_entity and level_schedule change the
+//   sleeper lists, num_asleep, the store's asleep flags and the timer wheel
+// - level_turret_target fills level::turret_targets on its first call in a
+//   tick
+// - particles and sounds, and state->tick_sounds/tick_bullet_sounds
+typedef enum {
+    LEVEL_COMMAND_SPAWN,
+    LEVEL_COMMAND_DAMAGE,
+    LEVEL_COMMAND_MONEY,
+    LEVEL_COMMAND_STAGE,
+    LEVEL_COMMAND_TRUCK_HEALTH,
+} level_command_type;
+
+typedef struct {
+    level_command_type type;
+    union {
+        struct {
+            entity_type type;
+            vec2s pos;
+
+            // initial entity::bullet, for bullets
+            vec2s velocity;
+            ivec2s target;
+            bool has_target;
+        } spawn;
+
+        struct {
+            entity_id target;
+            f32 amount;
+        } damage;
+
+        int money;
+        int stage;
+
+        // state->stats.truck_health
+        f32 truck_health;
+    };
+} level_command;
+
 typedef struct level_s {
     const level_data *data;
 
@@ -27,10 +95,70 @@ typedef struct level_s {
     int flags[LEVEL_WIDTH][LEVEL_HEIGHT]; // LTF_*
     int music_level[LEVEL_WIDTH][LEVEL_HEIGHT];
 
-    int last_free_entity;
-    entity *entities;
-    DLIST(entity) tile_entities[LEVEL_WIDTH][LEVEL_HEIGHT];
-    DLIST(entity) all_entities;
+    // entity storage, chunks are allocated as needed and never move so
+    // entity pointers stay valid. see level_new_entity.
+    entity *entity_chunks[MAX_ENTITY_CHUNKS];
+    int num_entity_chunks;
+
+    // stack of free entity indices, lowest on top
+    DYNLIST(u16) free_entities;
+
+    // live entities, most live at once and level_new_entity calls which found
+    // the pool full
+    int num_entities, peak_entities, failed_entities;
+
+    // entities by tile as pool indices (see level_entity_at), tile x, y's are
+    // grid_entities[grid_start[i] .. grid_start[i + 1]) for
+    // i = (x * LEVEL_HEIGHT) + y. a snapshot rebuilt by level_build_grid.
+    //
+    // grid_dirty is set by anything changing an entity's tile, spawning or
+    // deleting. level_tick rebuilds the grid before entities tick and
+    // freezes it until they are done, so ticks see where everything was at
+    // the start of the tick. between ticks, level_tile_grid rebuilds it when
+    // dirty.
+    int grid_start[(LEVEL_WIDTH * LEVEL_HEIGHT) + 1];
+    DYNLIST(u16) grid_entities;
+
+    // EIF_* flags of anything on each tile, for skipping tiles in queries
+    u8 grid_flags[LEVEL_WIDTH * LEVEL_HEIGHT];
+    bool grid_dirty, grid_frozen;
+
+    // the same for EIF_ENEMY entities only, with their aabbs alongside, so
+    // bullets can test enemies without touching anything else. see
+    // level_enemy_box_each. membership is as of the last rebuild like the
+    // grid, but entity_set_pos keeps the aabbs current through
+    // entity::enemy_box.
+    int enemy_start[(LEVEL_WIDTH * LEVEL_HEIGHT) + 1];
+    DYNLIST(u16) enemy_entities;
+    DYNLIST(aabb) enemy_boxes;
+
+    // what a turret on each tile shoots at (indexed like grid_start), for
+    // turret_targets_tick. see level_turret_target.
+    entity_id turret_targets[LEVEL_WIDTH * LEVEL_HEIGHT];
+    u64 turret_targets_tick;
+
+    entity_store hot;
+
+    // live entities by type in spawn order, and live entities with each EIF_*
+    // flag (by bit index). maintained by level_new_entity/level_delete_entity.
+    DLIST(entity) type_entities[ENTITY_TYPE_COUNT];
+    int num_type_entities[ENTITY_TYPE_COUNT];
+    int num_flag_entities[EIF_NUM_FLAGS];
+
+    // queued by level_push_command during level_tick
+    DYNLIST(level_command) commands;
+
+    // enemies on each region's tiles, kept by entity_set_pos
+    int region_enemies[LEVEL_REGIONS_X][LEVEL_REGIONS_Y];
+
+    // sleeping entities by what wakes them, see level_sleep_entity
+    DLIST(entity) sleepers[LEVEL_SLEEP_LISTS];
+    int num_asleep;
+
+    // periodic entity actions, see entity_timer. due_timers is scratch for
+    // level_tick.
+    timer_wheel timers;
+    DYNLIST(timer) due_timers;
 
     ivec2s start, finish;
 } level;
@@ -40,21 +168,93 @@ void level_destroy(level*);
 bool level_find_near_tile(level*, ivec2s, tile_type, ivec2s*);
 void level_go(level*);
 void level_tick(level*);
-void level_update(level*, f32 dt);
-void level_draw(const level*);
+// tiles from level, entities from the snapshot (see simthread.h)
+void level_draw(const level*, const render_snapshot*);
 void level_update_music(level*);
 
+// NULL if all MAX_ENTITIES are in use
 entity *level_new_entity(level*, entity_type);
 void level_delete_entity(level*, entity*);
+
+// queue a command for the end of this level_tick
+void level_push_command(level*, level_command);
 entity *level_get_entity(level*, entity_id);
 entity *level_find_entity(level*, entity_type);
-int level_get_tile_entities(level *l, ivec2s tile, entity **es, int n);
-int level_get_box_entities(level *l, const aabb *box, entity **es, int n);
+
+// iterator over entities on a tile or colliding with a box, see
+// level_tile_each and level_box_each. el is the current entity.
+typedef struct {
+    level *l;
+    const u16 *cell;
+    int i, n;
+
+    // box iterators only: the current tile, the tile range and the box.
+    // boxes are the aabbs matching cell for enemy iterators.
+    ivec2s tile, tmin, tmax;
+    aabb box;
+    const aabb *boxes;
+
+    entity *el;
+} level_iter;
+
+level_iter level_box_iter(level*, const aabb *box, bool enemies);
+bool level_box_iter_next(level_iter*);
+
+// for every entity whose aabb collides with *_box, as _it.el. no copies and
+// no limit on how many. the grid must not be rebuilt while iterating, which
+// it can't be during level_tick.
+#define level_box_each(_l, _box, _it)                                        \
+    for (level_iter _it = level_box_iter((_l), (_box), false);               \
+         level_box_iter_next(&_it);)
+
+// level_box_each for EIF_ENEMY entities only, tested against their current
+// aabbs in level::enemy_boxes
+#define level_enemy_box_each(_l, _box, _it)                                  \
+    for (level_iter _it = level_box_iter((_l), (_box), true);                \
+         level_box_iter_next(&_it);)
 
 typedef int (*f_entity_priority)(entity*, void*);
-entity *level_find_nearest_entity(level *l, ivec2s pos, f_entity_priority f_pri, void*);
+typedef int (*f_entity_priority_bound)(int, void*);
+
+// most results level_query_nearest can return
+#define LEVEL_QUERY_MAX_K 64
+
+// what level_query_nearest looks for
+typedef struct {
+    // only entities with any of these EIF_* flags, EIF_NONE for all
+    int flags;
+
+    // farthest ring of tiles to search (tiles are in ring r when r tiles away
+    // on either axis), < 0 for the whole level
+    int radius;
+
+    // higher is better, <= 0 rejects. ties go to whatever was found first,
+    // nearer rings are searched first.
+    f_entity_priority priority;
+
+    // highest priority anything on ring r (its argument) can have, the search stops once
+    // it has k results this can't beat. NULL to search every ring.
+    f_entity_priority_bound bound;
+
+    void *userdata;
+} level_query;
+
+// up to k (<= LEVEL_QUERY_MAX_K) best entities around pos by q->priority,
+// best first. returns how many were found.
+int level_query_nearest(
+    level*, ivec2s pos, const level_query *q, entity **es, int k);
 bool level_tile_has_entities(level*, ivec2s);
 
+// target for a turret on tile: the nearest ground enemy, or the nearest ship
+// if there are none. ENTITY_NONE if there are no enemies. every tile's target
+// comes from one breadth first search out from all enemies at once, done on
+// the first call each tick and shared by all turrets.
+entity_id level_turret_target(level*, ivec2s tile);
+
+// counting sort of all entities into level::grid_entities by tile, and of
+// enemies into level::enemy_entities
+void level_build_grid(level*);
+
 int level_path_default_weight(const level *l, ivec2s p, void*);
 
 typedef int (*f_path_weight)(const struct level_s*, ivec2s, void*);
@@ -68,6 +268,72 @@ bool level_path(
 
 bool level_has_enemies(level*);
 
+// stop ticking e until it is woken by a stage change (level_wake_all),
+// damage, one of its timers or, depending on wake, an enemy showing up. call from e's tick, it
+// is ticked until the end of the tick either way.
+void level_sleep_entity(level*, entity*, level_wake wake);
+
+// wake e if it is asleep, it is ticked from the next level_tick on (or this
+// one, from a timer)
+void level_wake_entity(level*, entity*);
+void level_wake_all(level*);
+
+// run action on e on tick, see entity_timer_fire. timers of deleted entities
+// lapse.
+void level_schedule(
+    level*, entity*, entity_timer action, int arg, u64 tick);
+
+// keep region_enemies up to date for an enemy which moved between tiles,
+// was_on_tile/from are its old entity::on_tile/tile
+void level_move_enemy(level*, entity*, bool was_on_tile, ivec2s from);
+
+// entity storage slot for index, must be < num_entity_chunks * chunk size
+ALWAYS_INLINE entity *level_entity_at(const level *l, int index) {
+    return &l->entity_chunks[index >> ENTITY_CHUNK_SHIFT]
+        [index & (ENTITY_CHUNK_SIZE - 1)];
+}
+
+// rebuild the grid if it is out of date and not frozen
+ALWAYS_INLINE void level_update_grid(level *l) {
+    if (l->grid_dirty && !l->grid_frozen) { level_build_grid(l); }
+}
+
+// level_tile_grid without level_update_grid, for loops over many tiles
+ALWAYS_INLINE const u16 *level_grid_cell(const level *l, ivec2s tile, int *n) {
+    const int i = (tile.x * LEVEL_HEIGHT) + tile.y;
+    *n = l->grid_start[i + 1] - l->grid_start[i];
+    return l->grid_entities + l->grid_start[i];
+}
+
+// pool indices of the *n entities on tile, for level_entity_at. valid until
+// the grid is next rebuilt.
+ALWAYS_INLINE const u16 *level_tile_grid(level *l, ivec2s tile, int *n) {
+    level_update_grid(l);
+    return level_grid_cell(l, tile, n);
+}
+
+ALWAYS_INLINE level_iter level_tile_iter(level *l, ivec2s tile) {
+    level_iter it = { .l = l };
+    it.cell = level_tile_grid(l, tile, &it.n);
+    return it;
+}
+
+ALWAYS_INLINE bool level_tile_iter_next(level_iter *it) {
+    if (it->i == it->n) { return false; }
+    it->el = level_entity_at(it->l, it->cell[it->i++]);
+    return true;
+}
+
+// for every entity on _tile, as _it.el. see level_box_each.
+#define level_tile_each(_l, _tile, _it)                                      \
+    for (level_iter _it = level_tile_iter((_l), (_tile));                    \
+         level_tile_iter_next(&_it);)
+
+// number of live entities with a (single) EIF_* flag
+ALWAYS_INLINE int level_num_flag_entities(const level *l, int flag) {
+    return l->num_flag_entities[__builtin_ctz(flag)];
+}
+
 ALWAYS_INLINE bool level_tile_in_bounds(ivec2s pos) {
     return pos.x >= 0 && pos.y >= 0 && pos.x < LEVEL_WIDTH && pos.y < LEVEL_HEIGHT;
 }
@@ -94,6 +360,15 @@ ALWAYS_INLINE ivec2s level_px_round_to_tile(ivec2s pos) {
     return level_tile_to_px(level_px_to_tile(pos));
 }
 
+ALWAYS_INLINE ivec2s level_tile_region(ivec2s pos) {
+    return (ivec2s) {{ pos.x / LEVEL_REGION_SIZE, pos.y / LEVEL_REGION_SIZE }};
+}
+
+ALWAYS_INLINE int level_region_enemies(const level *l, ivec2s pos) {
+    const ivec2s r = level_tile_region(pos);
+    return l->region_enemies[r.x][r.y];
+}
+
 ALWAYS_INLINE ivec2s level_tile_center_px(ivec2s pos) {
     const ivec2s px = level_tile_to_px(pos);
     return (ivec2s) {{ px.x + (TILE_SIZE_PX / 2), px.y + (TILE_SIZE_PX / 2) }};
@@ -1,4 +1,7 @@
 #include "palette.h"
+#include "governor.h"
+#include "profiler.h"
+#include "trace.h"
 #include "title.h"
 #include "util.h"
 #define CJAM_IMPL
@@ -61,8 +64,18 @@ struct {
     sg_image color, depth;
     sg_pass pass;
     sg_pass_action passaction;
+
+    // what was last rendered into color, static screens skip re-rendering
+    // when this does not change. valid only if it was a static screen, hash
+    // is not kept up to date otherwise.
+    bool valid;
+    u64 hash;
+    vec4s clear_color;
 } offscreen;
 
+// level/particles are batched here, see frame()
+static gfx_batcher level_batcher;
+
 static void _sg_logger(
         const char* tag,                // always "sg"
         uint32_t log_level,             // 0=panic, 1=error, 2=warning, 3=info
@@ -117,6 +130,7 @@ static void init() {
 
     /* gfx_sound_init(); */
 
+    entity_info_init();
     input_init(&state->input);
 
     sg_setup(&(sg_desc) {
@@ -161,6 +175,7 @@ static void init() {
             });
 
     gfx_batcher_init(&state->batcher);
+    gfx_batcher_init(&level_batcher);
 
     sg_image font_image;
     ASSERT(!gfx_load_image("font.png", &font_image));
@@ -191,9 +206,44 @@ static void deinit() {
     gfx_atlas_destroy(&state->atlas.ui);
     gfx_atlas_destroy(&state->atlas.icon);
     gfx_batcher_destroy(&state->batcher);
+    gfx_batcher_destroy(&level_batcher);
+}
+
+// fast-forward speeds cycled through with [F], 0 = uncapped
+static const int FF_SPEEDS[] = { 1, 2, 4, 8, 0 };
+
+static void cycle_speed() {
+    int i = 0;
+    while (i < (int) ARRLEN(FF_SPEEDS) && FF_SPEEDS[i] != state->time.speed) {
+        i++;
+    }
+
+    state->time.speed = FF_SPEEDS[(i + 1) % ARRLEN(FF_SPEEDS)];
+    LOG("fast-forward speed %d", state->time.speed);
+}
+
+// frame rate limit_frame() currently paces to, 0 = unlimited
+static int limit_fps() {
+    const bool idle =
+        state->stage == STAGE_MAIN_MENU
+        || (state->paused && state->stage != STAGE_TITLE);
+
+    // uncapped fast-forward wants every frame it can get
+    const bool uncapped =
+        state->stage == STAGE_PLAY && !state->paused && state->time.speed == 0;
+
+    if (uncapped) { return 0; }
+    return max(idle ? state->time.idle_fps : state->time.target_fps, 0);
 }
 
 static void frame() {
+    // wait for last frame's ticks, after this the level is ours again
+    simthread_join(&state->simthread);
+    state->time.second_ticks += state->simthread.ran;
+    state->simthread.ran = 0;
+
+    profiler_frame(&state->prof);
+
     if (state->hacks) {
         const bool
             skip = input_get(&state->input, "1") & INPUT_PRESS,
@@ -240,26 +290,64 @@ static void frame() {
         state->time.last_second = now;
     }
 
-    const u64 tick_time = state->time.delta + state->time.tick_remainder;
-    state->time.frame_ticks = min(tick_time / NS_PER_TICK, TICKS_PER_SECOND);
-    state->time.tick_remainder = tick_time % NS_PER_TICK;
+    // only fast-forward while actually playing
+    const int speed =
+        (state->stage == STAGE_PLAY && !state->paused) ? state->time.speed : 1;
+
+    bool capped = false;
+    u64 deadline = 0;
+    if (speed == 0) {
+        // uncapped, tick for about a frame at the target rate per kick so
+        // per-frame and per-kick overhead is paid once per batch rather than
+        // once per tick
+        const int fps =
+            state->time.target_fps > 0 ? state->time.target_fps : 60;
+        state->time.frame_ticks = U64_MAX;
+        state->time.tick_remainder = 0;
+        deadline = now + (1000000000ull / fps);
+    } else {
+        const u64
+            tick_time =
+                (state->time.delta * speed) + state->time.tick_remainder,
+            cap = TICKS_PER_SECOND * speed;
+        capped = tick_time / NS_PER_TICK > cap;
+        state->time.frame_ticks = min(tick_time / NS_PER_TICK, cap);
+        state->time.tick_remainder = tick_time % NS_PER_TICK;
+    }
+
+    // budget is the frame period, or a tick if frames are unlimited. work
+    // leaves out waiting, both frame limiting and swap (which blocks until
+    // vblank with vsync on).
+    const int fps = limit_fps();
+    state->time.pace_fps = fps;
+    const u64 *last = profiler_last(&state->prof);
+    if (last) {
+        governor_update(
+            &state->gov,
+            fps > 0 ? 1000000000ull / fps : NS_PER_TICK,
+            last[PZ_COUNT] - last[PZ_LIMIT] - last[PZ_SWAP],
+            capped);
+    }
 
-    state->time.second_ticks += state->time.frame_ticks;
     state->time.second_frames++;
 
-    input_update(&state->input);
+    PROFILE(&state->prof, PZ_INPUT) {
+        input_update(&state->input);
 
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-        case SDL_QUIT:
-            state->quit = true;
-            break;
-        }
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            switch (event.type) {
+            case SDL_QUIT:
+                state->quit = true;
+                break;
+            }
 
-        input_process(&state->input, &event);
+            input_process(&state->input, &event);
+        }
     }
 
+    profiler_update(&state->prof);
+
     // handle state transition
     if (state->last_stage != state->stage) {
         if (state->last_stage == STAGE_MAIN_MENU
@@ -319,10 +407,13 @@ static void frame() {
             state->paused = false;
         }
     } else {
-        ui_update();
+        PROFILE(&state->prof, PZ_UI_UPDATE) {
+            ui_update();
+        }
 
-        const f32 dt = state->time.delta / 1000000000.0f;
-        level_update(state->level, dt);
+        if (input_get(&state->input, "f") & INPUT_PRESS) {
+            cycle_speed();
+        }
     }
 
     if (!unpaused
@@ -333,65 +424,137 @@ static void frame() {
         }
     }
 
-    for (u64 i = 0; i < state->time.frame_ticks; i++) {
-        state->time.tick++;
-        state->time.animtick = state->time.tick / 20;
-        state->tick_bullet_sounds = 0;
-        state->tick_sounds = 0;
-
-        if (state->stage != STAGE_MAIN_MENU && !state->paused) {
-            level_tick(state->level);
-
-            // tick particles
-            dynlist_each(state->particles, it) {
-                particle_tick(it.el);
+    // frozen while paused so interpolated entities do not drift
+    if (state->stage != STAGE_MAIN_MENU && !state->paused) {
+        state->time.alpha =
+            speed == 0 ?
+                1.0f
+                : (state->time.tick_remainder / (f32) NS_PER_TICK);
+    }
 
-                if (it.el->delete) {
-                    dynlist_remove_it(state->particles, it);
-                }
-            }
-        }
+    // past here the sim thread may be ticking, which can change stage, tick
+    // and everything in the level. only the published snapshot is safe to
+    // read until simthread_join at the start of the next frame.
+    const stage stage = state->stage;
+    const bool paused = state->paused;
+
+    if (speed != 1
+        && state->time.tick - state->time.render_tick
+            < (u64) max(state->time.render_every, 1)) {
+        simthread_kick(
+            &state->simthread, state->time.frame_ticks, deadline,
+            state->time.alpha);
+        return;
     }
 
+    state->time.render_tick = state->time.tick;
+
     int w, h;
     SDL_GL_GetDrawableSize(state->window, &w, &h);
 
-    offscreen.passaction = (sg_pass_action) {
-        .colors[0] = {
-            .action = SG_ACTION_CLEAR,
-            .value = { state->clear_color.r, state->clear_color.g, state->clear_color.b, 1.0f }
-        },
-    };
-
-    sg_begin_pass(offscreen.pass, &offscreen.passaction);
-
-    if (state->stage == STAGE_MAIN_MENU) {
+    // everything reading live state is batched before the sim is kicked
+    if (stage == STAGE_MAIN_MENU) {
         main_menu_draw(&state->_main_menu);
-    } else if (state->stage == STAGE_TITLE) {
+    } else if (stage == STAGE_TITLE) {
         title_draw();
     } else {
         state->clear_color = COLOR_BLACK;
-        level_draw(state->level);
 
-        // draw particles
-#define MAX_DRAW_PARTICLES 1024
-        dynlist_each(state->particles, it) {
-            if (it.i >= MAX_DRAW_PARTICLES) { break; }
-            particle_draw(it.el);
+        PROFILE(&state->prof, PZ_UI_DRAW) {
+            ui_draw();
         }
 
-        ui_draw();
+        if (speed != 1) {
+            font_v(
+                IVEC2S(TARGET_SIZE.x / 2 - 8, TARGET_SIZE.y - 10),
+                Z_UI,
+                COLOR_WHITE,
+                FONT_DOUBLED,
+                speed == 0 ? ">>MAX" : ">>%dX",
+                speed);
+        }
+    }
+
+    profiler_draw(&state->prof);
+
+    // must be taken before the kick, the run publishes to the other snapshot
+    state->render = simthread_snapshot(&state->simthread);
+
+    simthread_kick(
+        &state->simthread, state->time.frame_ticks, deadline,
+        state->time.alpha);
+
+    // level and particles are drawn from the last snapshot while the sim
+    // runs. they go into their own batcher which is drawn first so they stay
+    // behind the UI regardless of batching order.
+    if (stage != STAGE_MAIN_MENU && stage != STAGE_TITLE) {
+        swap(state->batcher, level_batcher);
+
+        PROFILE(&state->prof, PZ_LEVEL_DRAW) {
+            level_draw(state->level, state->render);
+        }
+
+        PROFILE(&state->prof, PZ_PARTICLE_DRAW) {
+            dynlist_each(state->render->particles, it) {
+                particle_draw(it.el);
+            }
+        }
+
+        swap(state->batcher, level_batcher);
     }
 
     const mat4s
         proj = glms_ortho(0.0f, TARGET_SIZE.x, 0.0f, TARGET_SIZE.y, Z_MIN, Z_MAX),
         view = glms_mat4_identity();
 
-    gfx_batcher_draw(&state->batcher, &proj, &view);
-    gfx_batcher_clear(&state->batcher);
+    // paused, main menu and title only change on input, text or animtick, all
+    // of which show up in the batch. if it is the same as what is already in
+    // offscreen.color, just present that again.
+    const bool is_static =
+        stage == STAGE_MAIN_MENU
+        || stage == STAGE_TITLE
+        || paused;
+
+    // only hashed on static frames, where it can save a render
+    const u64 hash =
+        is_static ?
+            (gfx_batcher_hash(&level_batcher) * 31
+                + gfx_batcher_hash(&state->batcher))
+            : 0;
+    const bool dirty =
+        !is_static
+        || !offscreen.valid
+        || hash != offscreen.hash
+        || memcmp(
+            &offscreen.clear_color,
+            &state->clear_color,
+            sizeof(state->clear_color));
+
+    if (dirty) {
+        offscreen.valid = is_static;
+        offscreen.hash = hash;
+        offscreen.clear_color = state->clear_color;
+
+        offscreen.passaction = (sg_pass_action) {
+            .colors[0] = {
+                .action = SG_ACTION_CLEAR,
+                .value = { state->clear_color.r, state->clear_color.g, state->clear_color.b, 1.0f }
+            },
+        };
+
+        sg_begin_pass(offscreen.pass, &offscreen.passaction);
+
+        PROFILE(&state->prof, PZ_BATCHER_DRAW) {
+            gfx_batcher_draw(&level_batcher, &proj, &view);
+            gfx_batcher_draw(&state->batcher, &proj, &view);
+        }
 
-    sg_end_pass();
-    sg_commit();
+        sg_end_pass();
+        sg_commit();
+    }
+
+    gfx_batcher_clear(&level_batcher);
+    gfx_batcher_clear(&state->batcher);
 
     sg_pass_action pass_action = { 0 };
     pass_action.colors[0] = (sg_color_attachment_action) {
@@ -402,9 +565,52 @@ static void frame() {
     sg_begin_default_pass(&pass_action, w, h);
     gfx_screenquad(offscreen.color);
     sg_end_pass();
-    sg_commit();
 
-    SDL_GL_SwapWindow(state->window);
+    PROFILE(&state->prof, PZ_COMMIT) {
+        sg_commit();
+    }
+
+    PROFILE(&state->prof, PZ_SWAP) {
+        SDL_GL_SwapWindow(state->window);
+    }
+}
+
+// time before a frame deadline which is spun rather than slept, covers
+// SDL_Delay/scheduler oversleep
+#define LIMIT_SPIN_NS 2000000
+
+// sleeps then spins until the next frame is due
+static void limit_frame() {
+    // decided by frame(), stage/paused may be changing on the sim thread
+    const int fps = state->time.pace_fps;
+    if (fps <= 0) {
+        state->time.next_frame = 0;
+        return;
+    }
+
+    const u64 frame_ns = 1000000000ull / fps, now = time_ns();
+
+    // schedule from the last deadline to avoid drift, unless we fell behind
+    // by more than a frame (hitch, fps change) in which case start over
+    u64 next = state->time.next_frame + frame_ns;
+    if (state->time.next_frame == 0
+        || next + frame_ns < now
+        || next > now + frame_ns) {
+        next = now + frame_ns;
+    }
+    state->time.next_frame = next;
+
+    if (now >= next) {
+        return;
+    }
+
+    if (next - now > LIMIT_SPIN_NS) {
+        SDL_Delay((next - now - LIMIT_SPIN_NS) / 1000000);
+    }
+
+    while (time_ns() < next) {
+        // spin
+    }
 }
 
 // see state->h
@@ -412,6 +618,39 @@ global_state *state;
 
 int main(int argc, char *argv[]) {
     state = calloc(1, sizeof(*state));
+    state->time.speed = 1;
+    state->time.render_every = 1;
+    state->prof.hitch_ns = PROFILER_HITCH_MS * 1000000ull;
+    state->time.target_fps = 60;
+    state->time.idle_fps = 20;
+    state->time.vsync = false;
+
+    bool sim_thread = true;
+
+    // --speed N (0 = uncapped), --render-every N, --trace <file>,
+    // --hitch-ms N (0 = off), --fps N (0 = unlimited), --idle-fps N,
+    // --vsync 0|1, --sim-thread 0|1
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--speed")) {
+            state->time.speed = max(atoi(argv[i + 1]), 0);
+        } else if (!strcmp(argv[i], "--render-every")) {
+            state->time.render_every = max(atoi(argv[i + 1]), 1);
+        } else if (!strcmp(argv[i], "--hitch-ms")) {
+            state->prof.hitch_ns = max(atoi(argv[i + 1]), 0) * 1000000ull;
+        } else if (!strcmp(argv[i], "--fps")) {
+            state->time.target_fps = max(atoi(argv[i + 1]), 0);
+        } else if (!strcmp(argv[i], "--idle-fps")) {
+            state->time.idle_fps = max(atoi(argv[i + 1]), 0);
+        } else if (!strcmp(argv[i], "--vsync")) {
+            state->time.vsync = atoi(argv[i + 1]) != 0;
+        } else if (!strcmp(argv[i], "--sim-thread")) {
+            sim_thread = atoi(argv[i + 1]) != 0;
+        } else if (!strcmp(argv[i], "--trace")) {
+            trace_init(&state->trace, argv[i + 1]);
+        } else {
+            WARN("unknown argument %s", argv[i]);
+        }
+    }
 
     ASSERT(
         !SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_AUDIO),
@@ -461,18 +700,44 @@ int main(int argc, char *argv[]) {
     printf("GLSL Version={%s}\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 
     SDL_GL_MakeCurrent(state->window, state->glctx);
-    SDL_GL_SetSwapInterval(0);
+    if (state->time.vsync && SDL_GL_SetSwapInterval(1) != 0) {
+        WARN("could not enable vsync: %s", SDL_GetError());
+        state->time.vsync = false;
+    }
+
+    if (!state->time.vsync) {
+        SDL_GL_SetSwapInterval(0);
+    }
 
     init();
 
+#ifdef EMSCRIPTEN
+    // no threads without SharedArrayBuffer, tick inline
+    sim_thread = false;
+#endif // ifdef EMSCRIPTEN
+
+    simthread_init(&state->simthread, sim_thread);
+
 #ifdef EMSCRIPTEN
     emscripten_set_main_loop(frame, 0, 1);
 #else
-    while (!state->quit) { frame(); }
+    while (!state->quit) {
+        frame();
+
+        PROFILE(&state->prof, PZ_LIMIT) {
+            limit_frame();
+        }
+    }
 #endif // ifdef EMSCRIPTEN
 
+    simthread_destroy(&state->simthread);
     deinit();
 
+    if (state->trace.enabled) {
+        trace_write(&state->trace);
+        trace_destroy(&state->trace);
+    }
+
     SDL_GL_DeleteContext(state->glctx);
     SDL_DestroyWindow(state->window);
     SDL_Quit();
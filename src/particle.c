@@ -104,7 +104,8 @@ void particle_new_multi_splat(
     bool violent) {
     struct rand r =
         rand_create(pos.x * pos.y + ticks + mi + mi + state->time.tick);
-    const int n = rand_n(&r, mi, ma);
+    int n = rand_n(&r, mi, ma);
+    if (governor_shed(&state->gov, GOV_SHED_BURSTS)) { n = min(n, 1); }
     for (int i = 0; i < n; i++) {
         particle *p =
             particle_new_splat(pos, color, ticks + rand_n(&r, -10, 10));
@@ -122,7 +123,8 @@ void particle_new_multi_smoke(
     int ma) {
     struct rand r =
         rand_create(pos.x * pos.y + ticks + mi + mi + state->time.tick);
-    const int n = rand_n(&r, mi, ma);
+    int n = rand_n(&r, mi, ma);
+    if (governor_shed(&state->gov, GOV_SHED_BURSTS)) { n = min(n, 1); }
     for (int i = 0; i < n; i++) {
         particle_new_smoke(pos, color, ticks + rand_n(&r, -10, 10));
     }
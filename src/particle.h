@@ -19,6 +19,56 @@ typedef struct {
     };
 } particle;
 
+// particles past this are not drawn
+#define MAX_DRAW_PARTICLES 1024
+
+#ifdef HEADLESS
+// headless builds (see src/sim.c) spawn no particles
+ALWAYS_INLINE particle *particle_new_text(
+    vec2s pos,
+    vec4s color,
+    int ticks,
+    const char *fmt,
+    ...) { return NULL; }
+
+ALWAYS_INLINE particle *particle_new_smoke(
+    vec2s pos,
+    vec4s color,
+    int ticks) { return NULL; }
+
+ALWAYS_INLINE particle *particle_new_music(
+    vec2s pos,
+    int ticks) { return NULL; }
+
+ALWAYS_INLINE particle *particle_new_splat(
+    vec2s pos,
+    vec4s color,
+    int ticks) { return NULL; }
+
+ALWAYS_INLINE particle *particle_new_fancy(
+    vec2s pos,
+    vec4s color,
+    int ticks) { return NULL; }
+
+ALWAYS_INLINE void particle_new_multi_splat(
+    vec2s pos,
+    vec4s color,
+    int ticks,
+    int mi,
+    int ma,
+    bool violent) {}
+
+ALWAYS_INLINE void particle_new_multi_smoke(
+    vec2s pos,
+    vec4s color,
+    int ticks,
+    int mi,
+    int ma) {}
+
+ALWAYS_INLINE void particle_tick(particle *p) {}
+
+ALWAYS_INLINE void particle_draw(particle *p) {}
+#else
 particle *particle_new_text(
     vec2s pos,
     vec4s color,
@@ -62,3 +112,4 @@ void particle_new_multi_smoke(
 
 void particle_tick(particle*);
 void particle_draw(particle*);
+#endif // ifdef HEADLESS
@@ -0,0 +1,225 @@
+#include "profiler.h"
+#include "defs.h"
+#include "font.h"
+#include "gfx.h"
+#include "input.h"
+#include "level.h"
+#include "palette.h"
+#include "state.h"
+#include "trace.h"
+#include "util.h"
+
+#include <cjam/dynlist.h>
+#include <cjam/log.h>
+#include <cjam/sort.h>
+#include <cjam/time.h>
+
+// toggles HUD between off/table/graph
+#define PROFILER_KEY "f3"
+
+// frame time which the graph is scaled to
+#define PROFILER_GRAPH_MS 20.0f
+#define PROFILER_GRAPH_HEIGHT 64
+
+const char *PROFILER_ZONE_NAMES[PZ_COUNT] = {
+    [PZ_INPUT]         = "INPT",
+    [PZ_UI_UPDATE]     = "UIUP",
+    [PZ_LEVEL_TICK]    = "TICK",
+    [PZ_PARTICLE_TICK] = "PTCK",
+    [PZ_LEVEL_DRAW]    = "LVDR",
+    [PZ_PARTICLE_DRAW] = "PTDR",
+    [PZ_UI_DRAW]       = "UIDR",
+    [PZ_BATCHER_DRAW]  = "BTCH",
+    [PZ_COMMIT]        = "CMIT",
+    [PZ_SWAP]          = "SWAP",
+    [PZ_LIMIT]         = "LIMT",
+};
+
+const char *PROFILER_ZONE_TRACE_NAMES[PZ_COUNT] = {
+    [PZ_INPUT]         = "input",
+    [PZ_UI_UPDATE]     = "ui_update",
+    [PZ_LEVEL_TICK]    = "level_tick",
+    [PZ_PARTICLE_TICK] = "particle_tick",
+    [PZ_LEVEL_DRAW]    = "level_draw",
+    [PZ_PARTICLE_DRAW] = "particle_draw",
+    [PZ_UI_DRAW]       = "ui_draw",
+    [PZ_BATCHER_DRAW]  = "gfx_batcher_draw",
+    [PZ_COMMIT]        = "sg_commit",
+    [PZ_SWAP]          = "swap",
+    [PZ_LIMIT]         = "frame_limit",
+};
+
+static void report_hitch(const profiler *p, const u64 *frame) {
+    char buf[512], *q = buf, *end = buf + sizeof(buf);
+
+    for (int i = 0; i < PZ_COUNT; i++) {
+        q += snprintf(
+            q, end - q, " %s %.2f", PROFILER_ZONE_NAMES[i],
+            frame[i] / 1000000.0f);
+    }
+
+    WARN(
+        "hitch: %.2fms over %.2fms budget at tick %" PRIu64 ","
+        " %d entities, %d particles |%s",
+        frame[PZ_COUNT] / 1000000.0f,
+        p->hitch_ns / 1000000.0f,
+        state->time.tick,
+        state->level ? state->level->num_entities : 0,
+        (int) dynlist_size(state->particles),
+        buf);
+}
+
+void profiler_frame(profiler *p) {
+    const u64 now = time_ns();
+
+    if (p->frame_start != 0) {
+        if (state->trace.enabled) {
+            trace_push(
+                &state->trace, "frame", "frame", TRACE_TID_FRAME,
+                p->frame_start, now, "tick", state->time.tick);
+        }
+
+        u64 *entry = p->history[p->history_next];
+        memcpy(entry, p->current, sizeof(p->current));
+        entry[PZ_COUNT] = now - p->frame_start;
+
+        if (p->hitch_ns != 0 && entry[PZ_COUNT] > p->hitch_ns) {
+            report_hitch(p, entry);
+        }
+
+        p->history_next = (p->history_next + 1) % PROFILER_HISTORY;
+        p->history_size = min(p->history_size + 1, PROFILER_HISTORY);
+    }
+
+    memset(p->current, 0, sizeof(p->current));
+    p->frame_start = now;
+}
+
+const u64 *profiler_last(const profiler *p) {
+    if (p->history_size == 0) { return NULL; }
+    return p->history[
+        (p->history_next + PROFILER_HISTORY - 1) % PROFILER_HISTORY];
+}
+
+void profiler_begin(profiler *p, profiler_zone zone) {
+    p->start[zone] = time_ns();
+}
+
+void profiler_end(profiler *p, profiler_zone zone) {
+    const u64 now = time_ns();
+    p->current[zone] += now - p->start[zone];
+
+    if (state->trace.enabled) {
+        trace_push(
+            &state->trace, PROFILER_ZONE_TRACE_NAMES[zone], "frame",
+            trace_tid, p->start[zone], now, NULL, 0);
+    }
+}
+
+static int cmp_u64(const void *a, const void *b, void*) {
+    const u64 x = *(const u64*) a, y = *(const u64*) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+void profiler_stats(
+    const profiler *p, int zone, f32 *min, f32 *avg, f32 *p99) {
+    u64 samples[PROFILER_HISTORY], total = 0;
+    const int n = p->history_size;
+
+    if (n == 0) {
+        *min = *avg = *p99 = 0.0f;
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        samples[i] = p->history[i][zone];
+        total += samples[i];
+    }
+
+    sort(samples, n, sizeof(samples[0]), cmp_u64, NULL);
+
+    *min = samples[0] / 1000000.0f;
+    *avg = (total / (f32) n) / 1000000.0f;
+    *p99 = samples[((n - 1) * 99) / 100] / 1000000.0f;
+}
+
+void profiler_update(profiler *p) {
+    if (input_get(&state->input, PROFILER_KEY) & INPUT_PRESS) {
+        p->hud = (p->hud + 1) % PROFILER_HUD_COUNT;
+    }
+}
+
+static void draw_table(const profiler *p) {
+    char buf[1024], *q = buf, *end = buf + sizeof(buf);
+    q += snprintf(q, end - q, "$33    MIN  AVG  P99\n");
+
+    for (int i = 0; i <= PZ_COUNT; i++) {
+        f32 mi, avg, p99;
+        profiler_stats(p, i, &mi, &avg, &p99);
+
+        // not enough rows on screen for every zone, skip idle ones
+        if (i != PZ_COUNT && p99 < 0.01f) { continue; }
+        q += snprintf(
+            q, end - q,
+            "%s%-4s%5.2f%5.2f%5.2f\n",
+            i == PZ_COUNT ? "$33" : "$08",
+            i == PZ_COUNT ? "FRAM" : PROFILER_ZONE_NAMES[i],
+            mi, avg, p99);
+    }
+
+    font_str(
+        IVEC2S(2, TARGET_SIZE.y - 9),
+        Z_UI - 0.01f,
+        COLOR_WHITE,
+        FONT_DOUBLED,
+        buf);
+}
+
+static void draw_graph(const profiler *p) {
+    const ivec2s origin = IVEC2S(TARGET_SIZE.x - PROFILER_HISTORY - 2, 2);
+
+    // oldest frame on the left
+    for (int i = 0; i < p->history_size; i++) {
+        const int j =
+            (p->history_next - p->history_size + i + PROFILER_HISTORY)
+                % PROFILER_HISTORY;
+        const f32 ms = p->history[j][PZ_COUNT] / 1000000.0f;
+        const int h =
+            clamp(
+                (int) ((ms / PROFILER_GRAPH_MS) * PROFILER_GRAPH_HEIGHT),
+                1, PROFILER_GRAPH_HEIGHT);
+        const vec4s color =
+            palette_get(ms > 1000.0f / 60.0f ? PALETTE_RED : PALETTE_ALIEN_GREEN);
+
+        for (int y = 0; y < h; y++) {
+            gfx_batcher_push_sprite(
+                &state->batcher,
+                &state->atlas.tile,
+                &(gfx_sprite) {
+                    .pos = {{ origin.x + i, origin.y + y }},
+                    .index = {{ 1, 7 }},
+                    .color = color,
+                    .z = Z_UI - 0.01f,
+                    .flags = GFX_NO_FLAGS
+                });
+        }
+    }
+
+    f32 mi, avg, p99;
+    profiler_stats(p, PZ_COUNT, &mi, &avg, &p99);
+    font_v(
+        IVEC2S(2, TARGET_SIZE.y - 9),
+        Z_UI - 0.01f,
+        COLOR_WHITE,
+        FONT_DOUBLED,
+        "$33FRAME MS\n$08MIN %.2f\nAVG %.2f\nP99 %.2f\n$07MAX %dMS",
+        mi, avg, p99, (int) PROFILER_GRAPH_MS);
+}
+
+void profiler_draw(const profiler *p) {
+    switch (p->hud) {
+    case PROFILER_HUD_TABLE: draw_table(p); break;
+    case PROFILER_HUD_GRAPH: draw_graph(p); break;
+    default: break;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cjam/types.h>
+
+#include "defs.h"
+
+// frame phases timed by the profiler, see frame() in main.c
+typedef enum {
+    PZ_INPUT = 0,
+    PZ_UI_UPDATE,
+    PZ_LEVEL_TICK,
+    PZ_PARTICLE_TICK,
+    PZ_LEVEL_DRAW,
+    PZ_PARTICLE_DRAW,
+    PZ_UI_DRAW,
+    PZ_BATCHER_DRAW,
+    PZ_COMMIT,
+    PZ_SWAP,
+    PZ_LIMIT,
+    PZ_COUNT
+} profiler_zone;
+
+// number of frames kept for min/avg/p99 and the graph
+#define PROFILER_HISTORY 128
+
+// default hitch budget, a frame longer than a tick drops simulation time
+#define PROFILER_HITCH_MS MS_PER_TICK
+
+enum {
+    PROFILER_HUD_OFF = 0,
+    PROFILER_HUD_TABLE,
+    PROFILER_HUD_GRAPH,
+    PROFILER_HUD_COUNT
+};
+
+typedef struct {
+    int hud;
+
+    // frames longer than this are logged with their breakdown, 0 = off
+    u64 hitch_ns;
+
+    u64 frame_start;
+
+    // zone start times and ns accumulated in zones this frame
+    u64 start[PZ_COUNT], current[PZ_COUNT];
+
+    // ring buffer of past frames, [PZ_COUNT] is whole frame time
+    u64 history[PROFILER_HISTORY][PZ_COUNT + 1];
+    int history_next, history_size;
+} profiler;
+
+// short names for the HUD, long names for trace events
+extern const char *PROFILER_ZONE_NAMES[PZ_COUNT];
+extern const char *PROFILER_ZONE_TRACE_NAMES[PZ_COUNT];
+
+// times the following statement (or block) as zone _z. do not return or break
+// out of the timed statement.
+#define PROFILE(_p, _z)                                                      \
+    for (int CONCAT(_pz, __LINE__) = (profiler_begin((_p), (_z)), 0);         \
+         !CONCAT(_pz, __LINE__);                                             \
+         CONCAT(_pz, __LINE__) = (profiler_end((_p), (_z)), 1))
+
+// call at start of each frame, commits the last frame into history and reports
+// it if it went over hitch_ns
+void profiler_frame(profiler*);
+
+// last committed frame (zones + [PZ_COUNT] total) or NULL if none yet
+const u64 *profiler_last(const profiler*);
+
+void profiler_begin(profiler*, profiler_zone);
+void profiler_end(profiler*, profiler_zone);
+
+// min/avg/p99 in ms of a zone (or PZ_COUNT for the whole frame) over history
+void profiler_stats(
+    const profiler*, int zone, f32 *min, f32 *avg, f32 *p99);
+
+// handles HUD toggle key
+void profiler_update(profiler*);
+
+void profiler_draw(const profiler*);
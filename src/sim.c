@@ -0,0 +1,385 @@
+// headless simulation runner, build with "make sim"
+// runs level_tick without a window, GL context or audio so entity/level code
+// can be profiled on machines without a GPU.
+#define CJAM_IMPL
+
+#include <cjam/dlist.h>
+#include <cjam/dynlist.h>
+#include <cjam/rand.h>
+#include <cjam/sort.h>
+#include <cjam/time.h>
+#include <cjam/log.h>
+
+#include "defs.h"
+#include "entity.h"
+#include "level.h"
+#include "level_data.h"
+#include "state.h"
+#include "trace.h"
+#include "util.h"
+
+#ifndef HEADLESS
+#   error "sim.c must be built with -DHEADLESS"
+#endif // ifndef HEADLESS
+
+// buildings placed by --buildings
+static const entity_type sim_buildings[] = {
+    ENTITY_TURRET_L0,
+    ENTITY_TURRET_L1,
+    ENTITY_TURRET_L2,
+    ENTITY_CANNON_L0,
+    ENTITY_CANNON_L1,
+    ENTITY_MINE_L0,
+    ENTITY_RADAR_L0,
+    ENTITY_BOOMBOX,
+    ENTITY_DECOY_TRUCK,
+};
+
+// aliens spawned by --aliens
+static const entity_type sim_aliens[] = {
+    ENTITY_ALIEN_L0,
+    ENTITY_ALIEN_L1,
+    ENTITY_ALIEN_L2,
+    ENTITY_ALIEN_FAST,
+    ENTITY_ALIEN_TANK,
+    ENTITY_ALIEN_GHOST,
+};
+
+static struct {
+    int level;
+    u64 ticks;
+    int buildings, aliens;
+
+    // turrets stacked on random tiles regardless of can_place, for stress
+    // testing targeting
+    int turrets;
+
+    // aliens packed onto one tile with a mine, see crowd()
+    int crowd;
+    u64 seed;
+
+    // stay in STAGE_BUILD, where entities tick but do no AI, to measure
+    // per-entity overhead
+    bool build_stage;
+    const char *trace;
+} options = {
+    .level = 0,
+    .ticks = 30 * 60 * TICKS_PER_SECOND,
+    .buildings = 0,
+    .seed = 0x5EED,
+};
+
+static void usage(const char *name) {
+    fprintf(
+        stderr,
+        "usage: %s [--level N] [--ticks N] [--buildings N] [--turrets N]"
+        " [--aliens N] [--crowd N] [--seed N] [--build-stage 0|1]"
+        " [--trace FILE]\n",
+        name);
+}
+
+static void reset_stats() {
+    memset(&state->stats, 0, sizeof(state->stats));
+    state->stats.money = START_MONEY;
+    state->stats.truck_health = MAX_TRUCK_HEALTH;
+
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++) {
+        state->stats.unlocked[i] = true;
+    }
+}
+
+// place random buildings on free tiles
+static void build(struct rand *r, int n) {
+    int placed = 0, tries = 0;
+    while (placed < n && tries < n * 64) {
+        tries++;
+
+        const entity_type type =
+            sim_buildings[rand_n(r, 0, (int) ARRLEN(sim_buildings) - 1)];
+        const ivec2s tile =
+            IVEC2S(
+                rand_n(r, 0, LEVEL_WIDTH - 1),
+                rand_n(r, 0, LEVEL_HEIGHT - 1));
+
+        if (!ENTITY_INFO[type].can_place(tile)) {
+            continue;
+        }
+
+        entity *e = level_new_entity(state->level, type);
+        if (!e) { break; }
+
+        entity_set_pos(e, IVEC2S2V(level_tile_to_px(tile)));
+        placed++;
+    }
+
+    if (placed < n) {
+        WARN("only placed %d/%d buildings", placed, n);
+    }
+}
+
+// place n turrets on random tiles, any number to a tile
+static void fortify(struct rand *r, int n) {
+    for (int i = 0; i < n; i++) {
+        const ivec2s tile =
+            IVEC2S(
+                rand_n(r, 0, LEVEL_WIDTH - 1),
+                rand_n(r, 0, LEVEL_HEIGHT - 1));
+
+        entity *e = level_new_entity(state->level, ENTITY_TURRET_L0);
+        if (!e) { break; }
+
+        entity_set_pos(e, IVEC2S2V(level_tile_to_px(tile)));
+    }
+}
+
+// aliens packed by crowd() with their starting health, checked by
+// check_crowd()
+typedef struct {
+    entity_id id;
+    f32 health;
+} crowd_alien;
+
+static DYNLIST(crowd_alien) crowd_aliens;
+
+// set when a crowd couldn't be packed or the mine missed any of it, sim
+// exits nonzero
+static bool crowd_failed;
+
+// pack n aliens onto the tile of a new mine, which should go off on the
+// first tick in STAGE_PLAY and hit every one of them
+static void crowd(struct rand *r, int n) {
+    dynlist_resize(crowd_aliens, 0);
+
+    for (int tries = 0; tries < 1024; tries++) {
+        const ivec2s tile =
+            IVEC2S(
+                rand_n(r, 0, LEVEL_WIDTH - 1),
+                rand_n(r, 0, LEVEL_HEIGHT - 1));
+
+        if (!ENTITY_INFO[ENTITY_MINE_L0].can_place(tile)) {
+            continue;
+        }
+
+        const vec2s pos = IVEC2S2V(level_tile_to_px(tile));
+        entity *mine = level_new_entity(state->level, ENTITY_MINE_L0);
+        if (!mine) { break; }
+        entity_set_pos(mine, pos);
+
+        for (int i = 0; i < n; i++) {
+            entity *e = level_new_entity(state->level, ENTITY_ALIEN_L0);
+            if (!e) {
+                ERROR("only packed %d/%d aliens", i, n);
+                crowd_failed = true;
+                break;
+            }
+
+            entity_set_pos(e, pos);
+            *dynlist_push(crowd_aliens) =
+                (crowd_alien) { .id = e->id, .health = e->health };
+        }
+        return;
+    }
+
+    ERROR("no tile for a crowd");
+    crowd_failed = true;
+}
+
+// after the first tick, check the mine hit every crowd alien. damage is
+// applied at the end of the tick and the dead are only deleted on their next
+// tick, so every alien hit (killed or not) is still there with less health.
+// anything gone or unhurt was missed.
+static void check_crowd() {
+    int hit = 0;
+    dynlist_each(crowd_aliens, it) {
+        const entity *e = level_get_entity(state->level, it.el->id);
+        if (e && e->health < it.el->health) {
+            hit++;
+        }
+    }
+
+    const int n = dynlist_size(crowd_aliens);
+    printf("crowd: %d/%d aliens hit by the mine\n", hit, n);
+    if (hit != n) {
+        ERROR("mine missed %d crowded aliens", n - hit);
+        crowd_failed = true;
+    }
+    dynlist_resize(crowd_aliens, 0);
+}
+
+// entity pool stats over all restarts
+static struct {
+    int peak, failed, chunks;
+} pool;
+
+static void collect_pool_stats() {
+    if (!state->level) { return; }
+    pool.peak = max(pool.peak, state->level->peak_entities);
+    pool.failed += state->level->failed_entities;
+    pool.chunks = max(pool.chunks, state->level->num_entity_chunks);
+}
+
+// spawn aliens on random tiles, for stress testing
+static void invade(struct rand *r, int n) {
+    for (int i = 0; i < n; i++) {
+        const entity_type type =
+            sim_aliens[rand_n(r, 0, (int) ARRLEN(sim_aliens) - 1)];
+        const ivec2s tile =
+            IVEC2S(
+                rand_n(r, 0, LEVEL_WIDTH - 1),
+                rand_n(r, 0, LEVEL_HEIGHT - 1));
+
+        entity *e = level_new_entity(state->level, type);
+        if (!e) { break; }
+
+        entity_set_pos(e, IVEC2S2V(level_tile_to_px(tile)));
+    }
+}
+
+// (re)start the configured level, skipping straight to STAGE_PLAY unless
+// --build-stage
+static void start(struct rand *r) {
+    collect_pool_stats();
+    reset_stats();
+    state_set_level(state, options.level);
+    state_set_stage(state, STAGE_BUILD);
+    build(r, options.buildings);
+    fortify(r, options.turrets);
+
+    if (!options.build_stage) {
+        state_set_stage(state, STAGE_PLAY);
+        level_go(state->level);
+    }
+
+    invade(r, options.aliens);
+
+    if (options.crowd && !options.build_stage) {
+        crowd(r, options.crowd);
+    }
+}
+
+static int cmp_u64(const void *a, const void *b, void*) {
+    const u64 x = *(const u64*) a, y = *(const u64*) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// global state, see state.h
+global_state *state;
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i], *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!val) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (!strcmp(arg, "--level")) {
+            options.level = atoi(val);
+        } else if (!strcmp(arg, "--ticks")) {
+            options.ticks = strtoull(val, NULL, 10);
+        } else if (!strcmp(arg, "--buildings")) {
+            options.buildings = atoi(val);
+        } else if (!strcmp(arg, "--turrets")) {
+            options.turrets = atoi(val);
+        } else if (!strcmp(arg, "--aliens")) {
+            options.aliens = atoi(val);
+        } else if (!strcmp(arg, "--crowd")) {
+            options.crowd = atoi(val);
+        } else if (!strcmp(arg, "--seed")) {
+            options.seed = strtoull(val, NULL, 10);
+        } else if (!strcmp(arg, "--build-stage")) {
+            options.build_stage = atoi(val);
+        } else if (!strcmp(arg, "--trace")) {
+            options.trace = val;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+
+        i++;
+    }
+
+    if (options.level < 0 || options.level >= NUM_LEVELS) {
+        ERROR("no such level %d", options.level);
+        return 1;
+    }
+
+    state = calloc(1, sizeof(*state));
+    entity_info_init();
+
+    if (options.trace) {
+        trace_init(&state->trace, options.trace);
+    }
+
+    struct rand r = rand_create(options.seed);
+    start(&r);
+
+    u64 *samples = malloc(options.ticks * sizeof(u64));
+    int restarts = 0;
+
+    const u64 sim_start = time_ns();
+    for (u64 i = 0; i < options.ticks; i++) {
+        // level ended (truck delivered or destroyed), play it again
+        if (state->stage != (options.build_stage ? STAGE_BUILD : STAGE_PLAY)) {
+            start(&r);
+            restarts++;
+        }
+
+        state->time.tick++;
+        state->time.animtick = state->time.tick / 20;
+        state->tick_bullet_sounds = 0;
+        state->tick_sounds = 0;
+
+        const u64 tick_start = time_ns();
+        level_tick(state->level);
+        const u64 tick_end = time_ns();
+        samples[i] = tick_end - tick_start;
+
+        if (dynlist_size(crowd_aliens)) { check_crowd(); }
+
+        if (state->trace.enabled) {
+            trace_push(
+                &state->trace, "level_tick", "tick", TRACE_TID_FRAME,
+                tick_start, tick_end, "tick", state->time.tick);
+        }
+    }
+    const u64 sim_time = time_ns() - sim_start;
+
+    sort(samples, options.ticks, sizeof(u64), cmp_u64, NULL);
+
+    const f64 secs = sim_time / 1000000000.0;
+    printf(
+        "level %d: %" PRIu64 " ticks in %.3fs, %d restart(s)\n",
+        options.level, options.ticks, secs, restarts);
+    printf("ticks/s: %.1f\n", options.ticks / secs);
+
+    if (options.ticks > 0) {
+        printf(
+            "tick p50: %.3fms, p99: %.3fms, max: %.3fms\n",
+            samples[(options.ticks * 50) / 100] / 1000000.0,
+            samples[(options.ticks * 99) / 100] / 1000000.0,
+            samples[options.ticks - 1] / 1000000.0);
+    }
+
+    free(samples);
+
+    collect_pool_stats();
+    printf(
+        "entities: %d live (%d asleep), %d peak of %d, %d failed spawn(s),"
+        " %d chunk(s) (%zuKiB)\n",
+        state->level->num_entities, state->level->num_asleep,
+        pool.peak, MAX_ENTITIES, pool.failed,
+        pool.chunks, (pool.chunks * ENTITY_CHUNK_SIZE * sizeof(entity)) / 1024);
+
+    if (state->trace.enabled) {
+        trace_write(&state->trace);
+        trace_destroy(&state->trace);
+    }
+
+    dynlist_free(crowd_aliens);
+    level_destroy(state->level);
+    free(state->level);
+    free(state);
+    return crowd_failed ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#include "simthread.h"
+#include "level.h"
+#include "profiler.h"
+#include "state.h"
+#include "trace.h"
+#include "util.h"
+
+#include <cjam/dlist.h>
+#include <cjam/dynlist.h>
+#include <cjam/log.h>
+#include <cjam/time.h>
+
+static void publish(simthread *s) {
+    render_snapshot *snap = &s->snapshots[!s->front];
+    snap->tick = state->time.tick;
+    snap->animtick = state->time.animtick;
+    snap->stage = state->stage;
+    snap->alpha = s->alpha;
+
+    dynlist_resize(snap->entities, 0);
+    if (state->level) {
+        const entity_store *hot = &state->level->hot;
+        dynlist_resize(snap->entities, hot->size);
+        for (int i = 0; i < hot->size; i++) {
+            snap->entities[i] = *hot->entity[i];
+        }
+    }
+
+    // only the first MAX_DRAW_PARTICLES are ever drawn
+    const int n = min((int) dynlist_size(state->particles), MAX_DRAW_PARTICLES);
+    dynlist_resize(snap->particles, n);
+    if (n > 0) {
+        memcpy(snap->particles, state->particles, n * sizeof(particle));
+    }
+
+    s->front = !s->front;
+}
+
+static void run(simthread *s) {
+    const stage start_stage = state->stage;
+
+    u64 i = 0;
+    for (; i < s->ticks; i++) {
+        if (s->deadline != 0
+            && i != 0
+            && (state->stage != start_stage || time_ns() >= s->deadline)) {
+            break;
+        }
+
+        state->time.tick++;
+        state->time.animtick = state->time.tick / 20;
+        state->tick_bullet_sounds = 0;
+        state->tick_sounds = 0;
+
+        if (state->stage != STAGE_MAIN_MENU && !state->paused) {
+            PROFILE(&state->prof, PZ_LEVEL_TICK) {
+                level_tick(state->level);
+            }
+
+            // tick particles
+            PROFILE(&state->prof, PZ_PARTICLE_TICK) {
+                dynlist_each(state->particles, it) {
+                    particle_tick(it.el);
+
+                    if (it.el->delete) {
+                        dynlist_remove_it(state->particles, it);
+                    }
+                }
+            }
+        }
+    }
+
+    s->ran += i;
+    publish(s);
+}
+
+static int thread_main(void *p) {
+    simthread *s = p;
+    trace_tid = TRACE_TID_SIM;
+
+    while (true) {
+        SDL_SemWait(s->start);
+        if (s->quit) { break; }
+        run(s);
+        SDL_SemPost(s->done);
+    }
+
+    return 0;
+}
+
+void simthread_init(simthread *s, bool threaded) {
+    *s = (simthread) { 0 };
+
+    if (!threaded) { return; }
+
+    s->start = SDL_CreateSemaphore(0);
+    s->done = SDL_CreateSemaphore(0);
+    s->thread = SDL_CreateThread(thread_main, "sim", s);
+
+    if (!s->thread) {
+        WARN("could not create sim thread, ticking inline: %s", SDL_GetError());
+        SDL_DestroySemaphore(s->start);
+        SDL_DestroySemaphore(s->done);
+        s->start = s->done = NULL;
+    }
+}
+
+void simthread_destroy(simthread *s) {
+    simthread_join(s);
+
+    if (s->thread) {
+        s->quit = true;
+        SDL_SemPost(s->start);
+        SDL_WaitThread(s->thread, NULL);
+        SDL_DestroySemaphore(s->start);
+        SDL_DestroySemaphore(s->done);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        dynlist_free(s->snapshots[i].entities);
+        dynlist_free(s->snapshots[i].particles);
+    }
+}
+
+void simthread_kick(simthread *s, u64 ticks, u64 deadline, f32 alpha) {
+    ASSERT(!s->running);
+    s->ticks = ticks;
+    s->deadline = deadline;
+    s->alpha = alpha;
+
+    if (s->thread) {
+        s->running = true;
+        SDL_SemPost(s->start);
+    } else {
+        run(s);
+    }
+}
+
+void simthread_join(simthread *s) {
+    if (!s->running) { return; }
+    SDL_SemWait(s->done);
+    s->running = false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cjam/types.h>
+#include <cjam/dynlist.h>
+
+#include "defs.h"
+#include "entity.h"
+#include "particle.h"
+
+// immutable copy of everything level_draw/particle_draw read from the
+// simulation, published after each batch of ticks
+typedef struct render_snapshot_s {
+    u64 tick, animtick;
+    stage stage;
+
+    // see state->time.alpha
+    f32 alpha;
+
+    // copies for drawing only, pointers inside (path, list nodes) belong to
+    // the simulation and must not be followed
+    DYNLIST(entity) entities;
+    DYNLIST(particle) particles;
+} render_snapshot;
+
+// runs each frame's ticks (level_tick, particle_tick) on its own thread so
+// they overlap with rendering. the main thread hands over the level with
+// simthread_kick and must not touch it again until simthread_join.
+typedef struct {
+    SDL_Thread *thread;
+    SDL_sem *start, *done;
+    bool quit, running;
+
+    // parameters of the current run, see simthread_kick
+    u64 ticks, deadline;
+    f32 alpha;
+
+    // ticks run since last reset by the main thread, read after
+    // simthread_join
+    u64 ran;
+
+    // main thread draws from snapshots[front], runs publish to the other
+    render_snapshot snapshots[2];
+    int front;
+} simthread;
+
+// threaded = false runs ticks inline in simthread_kick
+void simthread_init(simthread*, bool threaded);
+void simthread_destroy(simthread*);
+
+// start running ticks, alpha is published with the resulting snapshot. if
+// deadline (a time_ns() value) is not 0 the run also stops, after at least one
+// tick, once it has passed or the stage changes.
+void simthread_kick(simthread*, u64 ticks, u64 deadline, f32 alpha);
+
+// wait for the last kick to finish, no-op if nothing is running
+void simthread_join(simthread*);
+
+// latest published snapshot, only call while not running. it stays valid
+// through the next run (which publishes to the other one) until the next
+// kick after that.
+ALWAYS_INLINE const render_snapshot *simthread_snapshot(const simthread *s) {
+    return &s->snapshots[s->front];
+}
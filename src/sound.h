@@ -2,4 +2,9 @@
 
 #include <cjam/types.h>
 
+#ifdef HEADLESS
+// headless builds (see src/sim.c) have no audio
+ALWAYS_INLINE void sound_play(const char *resource, f32 volume) {}
+#else
 void sound_play(const char *resource, f32 volume);
+#endif // ifdef HEADLESS
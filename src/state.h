@@ -7,6 +7,11 @@
 #include "gfx.h"
 #include "main_menu.h"
 #include "particle.h"
+#include "governor.h"
+#include "level.h"
+#include "profiler.h"
+#include "simthread.h"
+#include "trace.h"
 
 #include <cjam/dynlist.h>
 
@@ -52,8 +57,43 @@ typedef struct {
         u64 second_frames, fps;
         u64 tick;
         u64 animtick;
+
+        // fraction of the next tick elapsed, entities are drawn this far
+        // between their previous and current tick positions. published with
+        // each snapshot, see simthread.h.
+        f32 alpha;
+
+        // fast-forward tick multiplier, 0 = uncapped
+        int speed;
+
+        // when fast-forwarding, render only once every N ticks
+        int render_every;
+        u64 render_tick;
+
+        // frame limiter, see limit_frame() in main.c. 0 fps = unlimited.
+        // idle_fps is used while paused or on the main menu, pace_fps is
+        // whichever applies to the current frame.
+        int target_fps, idle_fps, pace_fps;
+        bool vsync;
+        u64 next_frame;
     } time;
 
+    // per-phase frame timings, HUD toggled with [F3]
+    profiler prof;
+
+    // chrome trace recorder, enabled with --trace <file>
+    trace trace;
+
+    // sheds cosmetic work when frames go over budget
+    governor gov;
+
+    // runs ticks alongside rendering, see frame() in main.c
+    simthread simthread;
+
+    // snapshot being drawn, draw code reads tick/stage/etc. from here rather
+    // than from state as the sim thread may be changing them
+    const render_snapshot *render;
+
     stats stats, old_stats;
 
     struct {
@@ -100,6 +140,9 @@ ALWAYS_INLINE void state_set_stage(global_state *s, stage stage) {
     s->stage = stage;
     s->stage_change_tick = s->time.tick;
     s->title_state = 0;
+
+    // everything asleep might have something to do in the new stage
+    if (s->level) { level_wake_all(s->level); }
 }
 
 void state_set_level(global_state *s, int level);
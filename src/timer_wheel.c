@@ -0,0 +1,78 @@
+#include "timer_wheel.h"
+
+#include <cjam/assert.h>
+#include <cjam/math.h>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+void timer_wheel_init(timer_wheel *w, u64 tick) {
+    *w = (timer_wheel) { .tick = tick };
+}
+
+void timer_wheel_destroy(timer_wheel *w) {
+    for (int l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+        for (int s = 0; s < TIMER_WHEEL_SLOTS; s++) {
+            dynlist_free(w->slots[l][s]);
+        }
+    }
+}
+
+// file t by how far away it is, t must not be due before w->tick
+static void file(timer_wheel *w, timer t) {
+    // lowest level whose slots are fine enough to tell t apart from now,
+    // capped at the farthest slot of the last level
+    const u64 delta = t.tick - w->tick;
+    int l = 0;
+    while (l < TIMER_WHEEL_LEVELS - 1
+           && delta >= (1ull << ((l + 1) * TIMER_WHEEL_BITS))) {
+        l++;
+    }
+
+    const u64 at =
+        min(t.tick,
+            w->tick
+                + (1ull << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1);
+    const int s = (at >> (l * TIMER_WHEEL_BITS)) & SLOT_MASK;
+    *dynlist_push(w->slots[l][s]) = t;
+}
+
+void timer_wheel_add(timer_wheel *w, timer t) {
+    t.tick = max(t.tick, w->tick + 1);
+    file(w, t);
+}
+
+// refile everything in slot s of level l, which is coming round
+static void cascade(timer_wheel *w, int l, int s) {
+    DYNLIST(timer) ts = w->slots[l][s];
+    w->slots[l][s] = NULL;
+
+    dynlist_each(ts, it) {
+        file(w, *it.el);
+    }
+
+    dynlist_free(ts);
+}
+
+void timer_wheel_advance(timer_wheel *w, u64 tick, DYNLIST(timer) *due) {
+    while (w->tick < tick) {
+        w->tick++;
+
+        // higher levels first, each slot coming round covers the next
+        // TIMER_WHEEL_SLOTS slots of the level below
+        for (int l = TIMER_WHEEL_LEVELS - 1; l > 0; l--) {
+            if (w->tick & ((1ull << (l * TIMER_WHEEL_BITS)) - 1)) {
+                continue;
+            }
+
+            cascade(w, l, (w->tick >> (l * TIMER_WHEEL_BITS)) & SLOT_MASK);
+        }
+
+        // level 0 slots only ever hold timers for the next time round
+        DYNLIST(timer) *slot = &w->slots[0][w->tick & SLOT_MASK];
+        dynlist_each(*slot, it) {
+            ASSERT(it.el->tick == w->tick);
+            *dynlist_push(*due) = *it.el;
+        }
+        dynlist_resize(*slot, 0);
+    }
+}
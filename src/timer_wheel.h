@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cjam/types.h>
+#include <cjam/dynlist.h>
+
+#include "defs.h"
+
+// hierarchical timer wheel of per-entity actions due on a tick.
+//
+// level 0 has one slot per tick for the next TIMER_WHEEL_SLOTS ticks, each
+// level after that one slot per TIMER_WHEEL_SLOTS slots of the level before.
+// timers are filed by how far away they are and moved down a level as the
+// wheel turns (see timer_wheel_advance), so adding and firing a timer is
+// O(1) however far ahead it is. timers further ahead than the wheel spans
+// are filed in its farthest slot and refiled when they come round.
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 3
+
+typedef struct {
+    // tick the timer is due on
+    u64 tick;
+    entity_id entity;
+
+    // entity_timer and action specific argument, see entity_timer_fire
+    u8 action, arg;
+} timer;
+
+typedef struct {
+    // last tick advanced to, timers are due after this
+    u64 tick;
+    DYNLIST(timer) slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} timer_wheel;
+
+// start empty on tick
+void timer_wheel_init(timer_wheel*, u64 tick);
+void timer_wheel_destroy(timer_wheel*);
+
+// timers due on or before the wheel's tick are due on the next one
+void timer_wheel_add(timer_wheel*, timer);
+
+// turn the wheel up to tick, appending timers due on the way to *due in tick
+// order
+void timer_wheel_advance(timer_wheel*, u64 tick, DYNLIST(timer) *due);
@@ -0,0 +1,102 @@
+#include "trace.h"
+#include "defs.h"
+
+#include <cjam/log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// entity_type -> name used for per-type level_tick events
+static const char *TYPE_NAMES[ENTITY_TYPE_COUNT] = {
+    [ENTITY_TYPE_NONE] = "none",
+#define TYPE_NAME(_n, _name, ...) [ENTITY_##_n] = #_name,
+    ENTITY_TYPES(TYPE_NAME)
+#undef TYPE_NAME
+};
+
+_Thread_local u8 trace_tid = TRACE_TID_FRAME;
+
+void trace_init(trace *t, const char *path) {
+    *t = (trace) { .enabled = true, .base = time_ns() };
+    snprintf(t->path, sizeof(t->path), "%s", path);
+    t->events = calloc(TRACE_CAPACITY, sizeof(trace_event));
+    LOG("tracing to %s", t->path);
+}
+
+void trace_destroy(trace *t) {
+    free(t->events);
+    *t = (trace) { 0 };
+}
+
+void trace_write(const trace *t) {
+    FILE *f = fopen(t->path, "w");
+    if (!f) {
+        WARN("could not open trace file %s", t->path);
+        return;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(
+        f,
+        "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+        "\"args\":{\"name\":\"frame\"}},\n"
+        "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+        "\"args\":{\"name\":\"sim\"}},\n"
+        "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+        "\"args\":{\"name\":\"level_tick entity types\"}}",
+        TRACE_TID_FRAME, TRACE_TID_SIM, TRACE_TID_ENTITY_TYPES);
+
+    // oldest first
+    const u64 size = min(t->count, TRACE_CAPACITY);
+    for (u64 i = t->count - size; i < t->count; i++) {
+        const trace_event *ev = &t->events[i % TRACE_CAPACITY];
+
+        // chrome wants microseconds
+        fprintf(
+            f,
+            ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\","
+            "\"cat\":\"%s\",\"ts\":%.3f,\"dur\":%.3f",
+            ev->tid, ev->name, ev->cat,
+            (ev->start - t->base) / 1000.0, ev->dur / 1000.0);
+
+        if (ev->arg_name) {
+            fprintf(
+                f, ",\"args\":{\"%s\":%" PRIi64 "}", ev->arg_name, ev->arg);
+        }
+
+        fprintf(f, "}");
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    LOG("wrote %" PRIu64 " trace events to %s", size, t->path);
+}
+
+void trace_tick_begin(trace *t) {
+    memset(t->type_ns, 0, sizeof(t->type_ns));
+    memset(t->type_count, 0, sizeof(t->type_count));
+    t->tick_start = time_ns();
+}
+
+void trace_tick_end(trace *t) {
+    // each type's span is timed on its own, timers and commands in between
+    // aren't, so the totals are laid out back-to-back from the start of the
+    // tick on their own track
+    u64 start = t->tick_start;
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++) {
+        if (t->type_count[i] == 0) { continue; }
+
+        trace_push(
+            t,
+            TYPE_NAMES[i],
+            "entity",
+            TRACE_TID_ENTITY_TYPES,
+            start,
+            start + t->type_ns[i],
+            "count",
+            t->type_count[i]);
+        start += t->type_ns[i];
+    }
+}
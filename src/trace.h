@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cjam/types.h>
+#include <cjam/math.h>
+#include <cjam/time.h>
+
+#include "defs.h"
+
+// chrome trace event recorder, output loads in chrome://tracing or perfetto.
+// events go into a fixed ring buffer (oldest are overwritten) and are written
+// out as JSON by trace_write.
+
+// number of events kept
+#define TRACE_CAPACITY (1 << 18)
+
+// trace "threads", used to separate overlapping tracks in the viewer
+enum {
+    TRACE_TID_FRAME = 1,
+    TRACE_TID_SIM,
+    TRACE_TID_ENTITY_TYPES,
+};
+
+// track of the calling thread, TRACE_TID_FRAME unless changed by the thread
+extern _Thread_local u8 trace_tid;
+
+typedef struct {
+    const char *name, *cat;
+    u64 start, dur;
+    const char *arg_name;
+    i64 arg;
+    u8 tid;
+} trace_event;
+
+typedef struct {
+    bool enabled;
+
+    // file written to by trace_write
+    char path[256];
+
+    // timestamps are written relative to this
+    u64 base;
+
+    // total events pushed, atomically incremented so any thread can push.
+    // the ring holds the last min(count, TRACE_CAPACITY).
+    trace_event *events;
+    u64 count;
+
+    // per-entity type ns/counts accumulated within the current level_tick
+    u64 tick_start, type_ns[ENTITY_TYPE_COUNT];
+    int type_count[ENTITY_TYPE_COUNT];
+} trace;
+
+// start recording, events are written to path on trace_write
+void trace_init(trace*, const char *path);
+
+void trace_destroy(trace*);
+
+// write all buffered events to trace->path
+void trace_write(const trace*);
+
+ALWAYS_INLINE void trace_push(
+    trace *t,
+    const char *name,
+    const char *cat,
+    u8 tid,
+    u64 start,
+    u64 end,
+    const char *arg_name,
+    i64 arg) {
+    const u64 i = __atomic_fetch_add(&t->count, 1, __ATOMIC_RELAXED);
+    t->events[i % TRACE_CAPACITY] = (trace_event) {
+        .name = name,
+        .cat = cat,
+        .start = start,
+        .dur = end - start,
+        .arg_name = arg_name,
+        .arg = arg,
+        .tid = tid,
+    };
+}
+
+// per-entity type accounting for level_tick, only called when enabled and
+// only from the thread running level_tick
+void trace_tick_begin(trace*);
+void trace_tick_end(trace*);
+
+ALWAYS_INLINE void trace_tick_entities(
+    trace *t, entity_type type, int n, u64 ns) {
+    t->type_ns[type] += ns;
+    t->type_count[type] += n;
+}
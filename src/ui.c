@@ -273,11 +273,15 @@ static bool update_cursor() {
             } else {
 
                 const ivec2s tile = state->input.cursor.tile;
-                dlist_each(tile_node, &state->level->tile_entities[tile.x][tile.y], it) {
-                    entity_info *info = &ENTITY_INFO[it.el->type];
+                int n;
+                const u16 *cell = level_tile_grid(state->level, tile, &n);
+                for (int i = 0; i < n; i++) {
+                    entity *e = level_entity_at(state->level, cell[i]);
+                    entity_info *info = &ENTITY_INFO[e->type];
                     if (info->flags & EIF_PLACEABLE) {
                         // reclaim
-                        it.el->delete = true;
+                        e->delete = true;
+                        level_wake_entity(state->level, e);
                         sound_play("explode.wav", 1.0f);
 
                         const int amount = info->buy_price / 2;
@@ -308,7 +312,14 @@ static bool update_cursor() {
                     in_level &&
                     (!info->can_place || info->can_place(state->input.cursor.tile));
 
-            if (in_level && can_place) {
+            entity *e =
+                in_level && can_place ?
+                    level_new_entity(state->level, state->ui.place_entity)
+                    : NULL;
+
+            if (e) {
+                entity_set_pos(e, IVEC2S2V(state->input.cursor.tile_px));
+
                 sound_play("select_hi.wav", 1.0f);
                 state->stats.money -= info->buy_price;
 
@@ -318,9 +329,6 @@ static bool update_cursor() {
                     TICKS_PER_SECOND,
                     "-%d",
                     info->buy_price);
-
-                entity *e = level_new_entity(state->level, state->ui.place_entity);
-                entity_set_pos(e, IVEC2S2V(state->input.cursor.tile_px));
             } else if (!in_level) {
                 LOG("cancelling placing %d, out of level", state->ui.place_entity);
                 state->ui.place_entity = ENTITY_TYPE_NONE;
@@ -598,14 +606,15 @@ void draw_advice() {
 static int get_building_reclaim_bonus(level *l) {
     int res = 0;
 
-    dlist_each(node, &l->all_entities, it) {
-        if (E_INFO(it.el)->flags & EIF_PLACEABLE) {
-            const int max_health = E_INFO(it.el)->max_health;
+    for (int i = 0; i < l->hot.size; i++) {
+        const entity_info *info = &ENTITY_INFO[l->hot.type[i]];
+        if (info->flags & EIF_PLACEABLE) {
+            const int max_health = info->max_health;
             const f32 condition =
                 max_health > 0 ?
-                    ifnan(it.el->health / (f32) E_INFO(it.el)->max_health, 0)
+                    ifnan(l->hot.health[i] / (f32) max_health, 0)
                     : 1;
-            res += E_INFO(it.el)->buy_price * condition * 0.55f;
+            res += info->buy_price * condition * 0.55f;
         }
     }
 